@@ -0,0 +1,151 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+//
+// Add -O2 -DNDEBUG to skip the cross-check against the forward
+// simulation
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Same representation as doit.cc: one string per stack, index 0 is
+// the bottom
+vector<string> read_stacks() {
+  vector<string> lines;
+  string line;
+  while (getline(cin, line) && !line.empty())
+    lines.push_back(line);
+  assert(!lines.empty());
+  auto stack_labels = lines.back();
+  assert((stack_labels.length() + 1) % 4 == 0);
+  size_t num_stacks = (stack_labels.length() + 1) / 4;
+  lines.pop_back();
+  vector<string> stacks(num_stacks);
+  while (!lines.empty()) {
+    line = lines.back();
+    assert(line.length() == stack_labels.length());
+    lines.pop_back();
+    for (size_t i = 0; i < num_stacks; ++i) {
+      char item = line[4 * i + 1];
+      if (item != ' ')
+        stacks[i].push_back(item);
+    }
+  }
+  return stacks;
+}
+
+struct crane_move {
+  unsigned count;
+  unsigned from;
+  unsigned to;
+};
+
+vector<crane_move> read_moves(size_t num_stacks) {
+  vector<crane_move> moves;
+  unsigned count, from, to;
+  while (scanf(" move %u from %u to %u ", &count, &from, &to) == 3) {
+    assert(1 <= from && from <= num_stacks);
+    assert(1 <= to && to <= num_stacks);
+    moves.push_back({ count, from - 1, to - 1 });
+  }
+  return moves;
+}
+
+// The forward simulation from doit.cc, used only for checking
+string forward_sim(vector<string> stacks, vector<crane_move> const &moves,
+                   bool reverses) {
+  for (auto const &m : moves) {
+    string &from = stacks[m.from];
+    string &to = stacks[m.to];
+    assert(from.length() >= m.count);
+    if (m.from == m.to)
+      continue;
+    string crates = from.substr(from.length() - m.count);
+    from.resize(from.length() - m.count);
+    if (reverses)
+      to.append(crates.rbegin(), crates.rend());
+    else
+      to.append(crates);
+  }
+  string tops;
+  for (auto const &stack : stacks) {
+    assert(!stack.empty());
+    tops.push_back(stack.back());
+  }
+  return tops;
+}
+
+// Only the top of each stack matters at the end, so rather than
+// shuffling crates around, start from each final top position and
+// walk the moves backwards to find where that crate started out.  A
+// position is (stack, depth), with depth 0 being the top of the
+// stack.  Undoing a move:
+//   On the "to" stack, the top count crates came from the top of the
+//   "from" stack (in reverse order if the crane moves one at a time),
+//   and anything deeper was count crates higher before the move.
+//   On the "from" stack, everything was count crates deeper.
+//   A move from a stack to itself changes nothing: moving the crates
+//   one at a time puts each straight back where it was, and moving
+//   them all at once puts the block back as it was.
+// That's O(moves * stacks) and never looks at any crates until the
+// final lookup.
+string reverse_replay(vector<string> const &stacks,
+                      vector<crane_move> const &moves, bool reverses) {
+  size_t num_stacks = stacks.size();
+  vector<unsigned> stack(num_stacks);
+  vector<size_t> depth(num_stacks, 0);
+  for (size_t i = 0; i < num_stacks; ++i)
+    stack[i] = i;
+  for (auto m = moves.rbegin(); m != moves.rend(); ++m) {
+    if (m->from == m->to)
+      continue;
+    for (size_t i = 0; i < num_stacks; ++i) {
+      if (stack[i] == m->to) {
+        if (depth[i] < m->count) {
+          stack[i] = m->from;
+          if (reverses)
+            depth[i] = m->count - 1 - depth[i];
+        } else
+          depth[i] -= m->count;
+      } else if (stack[i] == m->from)
+        depth[i] += m->count;
+    }
+  }
+  string tops;
+  for (size_t i = 0; i < num_stacks; ++i) {
+    auto const &origin = stacks[stack[i]];
+    assert(depth[i] < origin.length());
+    tops.push_back(origin[origin.length() - 1 - depth[i]]);
+  }
+  return tops;
+}
+
+void crane_sim(bool reverses) {
+  auto stacks = read_stacks();
+  auto moves = read_moves(stacks.size());
+  auto tops = reverse_replay(stacks, moves, reverses);
+  assert(tops == forward_sim(stacks, moves, reverses));
+  cout << tops << '\n';
+}
+
+void part1() { crane_sim(true); }
+
+void part2() { crane_sim(false); }
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
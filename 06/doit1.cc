@@ -0,0 +1,88 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+// ./doit1 4 14 ... < input  # any set of window sizes in one pass
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+
+// Streaming version that handles multiple window sizes at once.
+//
+// Instead of counting occurrences in a particular window, track the
+// position where each character was last seen.  Then the length of
+// the longest run of distinct characters ending at the current
+// position is one more than the previous run, except that it can't
+// reach back past the last time the current character was seen.
+// Window size n syncs at the first position where that run is >= n.
+// Since a run long enough for some n is long enough for all smaller
+// ones, the sizes are checked from smallest to largest, and each is
+// reported as soon as it's found.
+//
+// There's no need to keep any of the signal around, so memory is
+// just the block buffer and the last-seen table, regardless of the
+// signal length or window sizes.
+void find_syncs(vector<size_t> sizes) {
+  sort(sizes.begin(), sizes.end());
+  sizes.erase(unique(sizes.begin(), sizes.end()), sizes.end());
+  // Positions are 1-based so that 0 means never seen
+  array<size_t, 256> last_seen;
+  fill(last_seen.begin(), last_seen.end(), 0);
+  size_t pos = 0;
+  size_t run = 0;
+  // Next window size to find
+  size_t next = 0;
+  array<char, 65536> block;
+  size_t len;
+  while (next < sizes.size() &&
+         (len = fread(block.data(), 1, block.size(), stdin)) > 0) {
+    for (size_t i = 0; i < len && next < sizes.size(); ++i) {
+      unsigned char c = block[i];
+      if (c == '\n') {
+        // End of the signal
+        next = sizes.size();
+        break;
+      }
+      ++pos;
+      run = min(run + 1, pos - last_seen[c]);
+      last_seen[c] = pos;
+      for (; next < sizes.size() && run >= sizes[next]; ++next)
+        if (sizes.size() == 1)
+          cout << pos << endl;
+        else
+          cout << sizes[next] << ": " << pos << endl;
+    }
+  }
+}
+
+void part1() { find_syncs({ 4 }); }
+
+void part2() { find_syncs({ 14 }); }
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " size... < input\n";
+    exit(1);
+  }
+  if (argc > 2 || atoi(argv[1]) > 2) {
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+      int n = atoi(argv[i]);
+      assert(n > 0);
+      sizes.push_back(n);
+    }
+    find_syncs(sizes);
+  } else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -0,0 +1,228 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -O3 -march=native -o doit2 doit2.cc
+// ./doit2 1 < input  # part 1
+// ./doit2 2 < input  # part 2
+// ./doit2 bench [megabytes]  # time all the variants
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+
+// All the variants return the number of characters processed up to
+// the end of the first window of n distinct characters, or len if
+// there's no such window.  The bitmask ones assume lowercase letters
+// (anything is folded into 32 bits).
+
+// Naive
+size_t find_naive(char const *s, size_t len, size_t n) {
+  auto sync = [&](size_t pos) {
+                for (size_t i = 0; i < n; ++i)
+                  for (size_t j = i + 1; j < n; ++j)
+                    if (s[pos - i] == s[pos - j])
+                      return false;
+                return true;
+              };
+  size_t pos;
+  for (pos = n - 1; pos < len && !sync(pos); ++pos)
+    ;
+  return min(pos + 1, len);
+}
+
+// Boyer-Moore-like, see doit.cc for the explanation of the skip
+size_t find_boyer_moore(char const *s, size_t len, size_t n) {
+  auto sync = [&](size_t &pos) {
+                for (size_t skip = n - 1; skip > 0; --skip) {
+                  size_t j = n - skip;
+                  for (size_t i = 0; i < j; ++i)
+                    if (s[pos - i] == s[pos - j]) {
+                      pos += skip;
+                      return false;
+                    }
+                }
+                return true;
+              };
+  size_t pos;
+  for (pos = n - 1; pos < len && !sync(pos); )
+    ;
+  return min(pos + 1, len);
+}
+
+// Set-based, as in doit.cc
+size_t find_set(char const *s, size_t len, size_t n) {
+  array<unsigned, 256> occurrences;
+  fill(occurrences.begin(), occurrences.end(), 0);
+  unsigned num_unique = 0;
+  size_t i;
+  for (i = 0; i < len && num_unique < n; ++i) {
+    if (i >= n && --occurrences[(unsigned char)s[i - n]] == 0)
+      --num_unique;
+    if (occurrences[(unsigned char)s[i]]++ == 0)
+      ++num_unique;
+  }
+  return i;
+}
+
+// One-hot letter mask
+inline uint32_t mask(char c) { return uint32_t(1) << (c & 31); }
+
+// Running XOR of the masks in the window.  A letter that occurs an
+// even number of times cancels out, so the popcount can only reach n
+// when all n letters are distinct.
+size_t find_xor(char const *s, size_t len, size_t n) {
+  uint32_t window = 0;
+  for (size_t i = 0; i < len; ++i) {
+    window ^= mask(s[i]);
+    if (i >= n)
+      window ^= mask(s[i - n]);
+    if (i + 1 >= n && size_t(__builtin_popcount(window)) == n)
+      return i + 1;
+  }
+  return len;
+}
+
+// Check the window ending at e by accumulating masks from the end
+// backwards.  If the letter at e-k has already been seen then no
+// window containing e-k can work, so the next candidate window ends
+// at e-k+n.
+size_t find_bitmask(char const *s, size_t len, size_t n, size_t e) {
+  while (e < len) {
+    uint32_t seen = 0;
+    size_t k;
+    for (k = 0; k < n; ++k) {
+      uint32_t m = mask(s[e - k]);
+      if (seen & m)
+        break;
+      seen |= m;
+    }
+    if (k == n)
+      return e + 1;
+    e += n - k;
+  }
+  return len;
+}
+
+size_t find_bitmask(char const *s, size_t len, size_t n) {
+  return find_bitmask(s, len, n, n - 1);
+}
+
+// 16 lanes of letter masks, one per window end
+using u8x16 = uint8_t __attribute__((vector_size(16)));
+using u32x16 = uint32_t __attribute__((vector_size(64)));
+
+// The vector helpers work in place to avoid passing wide vectors by
+// value (which has ABI issues when the lanes don't fit a register)
+
+// OR in the masks for the 16 characters starting at p
+inline void or_masks16(u32x16 &x, char const *p) {
+  u8x16 bytes;
+  memcpy(&bytes, p, sizeof(bytes));
+  u32x16 letters = __builtin_convertvector(bytes & 31, u32x16);
+  x |= (u32x16{} + 1) << letters;
+}
+
+inline void popcount16(u32x16 &x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f;
+  x = (x * 0x01010101) >> 24;
+}
+
+// Vectorized: OR together the masks of n shifted copies of the input
+// to get the window masks for 16 consecutive window ends at once, and
+// look for a lane with n bits set.  If there's no hit, the last
+// window in the block gives a skip just like find_bitmask.  The
+// leftovers at the end are handled by find_bitmask.
+size_t find_simd(char const *s, size_t len, size_t n) {
+  assert(0 < n && n <= 32);
+  size_t e = n - 1;
+  while (e + 16 <= len) {
+    u32x16 window = {};
+    for (size_t j = 0; j < n; ++j)
+      or_masks16(window, s + e - j);
+    popcount16(window);
+    auto hit = window == uint32_t(n);
+    for (unsigned k = 0; k < 16; ++k)
+      if (hit[k])
+        return e + k + 1;
+    size_t last = e + 15;
+    uint32_t seen = 0;
+    size_t k;
+    for (k = 0; (seen & mask(s[last - k])) == 0; ++k)
+      seen |= mask(s[last - k]);
+    e = max(e + 16, last + n - k);
+  }
+  return find_bitmask(s, len, n, e);
+}
+
+void find_sync(size_t n) {
+  string line;
+  getline(cin, line);
+  cout << find_simd(line.data(), line.length(), n) << '\n';
+}
+
+void part1() { find_sync(4); }
+
+void part2() { find_sync(14); }
+
+// Time everything on a large signal of random letters drawn from an
+// alphabet that's one too small for a sync, followed by n distinct
+// letters so that the marker is near the end
+void bench(size_t megabytes) {
+  using finder = size_t (*)(char const *, size_t, size_t);
+  vector<pair<char const *, finder>> variants = {
+    { "naive", find_naive },
+    { "boyer-moore", find_boyer_moore },
+    { "set", find_set },
+    { "xor", find_xor },
+    { "bitmask", find_bitmask },
+    { "simd", find_simd }
+  };
+  size_t len = megabytes << 20;
+  vector<char> signal(len);
+  for (size_t n : { 4, 14 }) {
+    assert(len >= n);
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < len - n; ++i) {
+      // xorshift64
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      signal[i] = 'a' + (state >> 32) % (n - 1);
+    }
+    for (size_t i = 0; i < n; ++i)
+      signal[len - n + i] = 'z' - i;
+    size_t expected = find_set(signal.data(), len, n);
+    for (auto const &[name, find] : variants) {
+      auto start = chrono::steady_clock::now();
+      size_t pos = find(signal.data(), len, n);
+      chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+      assert(pos == expected);
+      cout << "n=" << n << ' ' << name << ": " << elapsed.count() << "s, "
+           << megabytes / elapsed.count() << " MB/s\n";
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || (argc > 2 && strcmp(argv[1], "bench") != 0)) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " bench [megabytes]\n";
+    exit(1);
+  }
+  if (strcmp(argv[1], "bench") == 0)
+    bench(argc > 2 ? atoi(argv[2]) : 1024);
+  else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -0,0 +1,415 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit2 doit2.cc
+// ./doit2 1 < input  # part 1
+// ./doit2 2 < input  # part 2
+// ./doit2 le X < input    # directories with total size <= X
+// ./doit2 ge Y < input    # smallest directory with total size >= Y
+// ./doit2 size P < input  # total size of path P
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+#include <cstdint>
+#include <cassert>
+
+using namespace std;
+
+// Same file system model as doit.cc, but stored in a few flat arrays
+// instead of nested maps so that huge logs don't turn into millions
+// of small allocations:
+//   Inodes are integer ids indexing a vector; root is 0
+//   Each distinct name is stored once in a single string pool
+//   Directory entries live in one open-addressed hash table keyed by
+//   (parent id, name id)
+// Totals are kept up to date as the log is parsed, in post-order like
+// doit1.cc: a new file adds its size to its directory, and when the
+// log leaves a directory, whatever that directory's total has gained
+// since it was last left gets passed up to its parent.  So every
+// directory that isn't on the current path has a correct total, and
+// reading costs O(1) per line no matter how deep the tree is.
+// Directory totals are then sorted into an index that answers the
+// size queries with binary searches.
+
+using id = uint32_t;
+id const none = ~id(0);
+
+// Open-addressed hash table mapping keys to ids.  The keys themselves
+// live elsewhere; the table holds only each key's hash and id, and
+// the caller supplies the equality test.
+struct id_table {
+  vector<pair<uint64_t, id>> slots;
+  size_t count{0};
+
+  id_table() : slots(1024, { 0, none }) {}
+
+  // Return the id for hash h if same(id) holds for some entry, else
+  // none
+  template <typename Same>
+  id find(uint64_t h, Same same) const;
+
+  // Like find, but if there's no match, call make() to get a new id
+  // and insert it
+  template <typename Same, typename Make>
+  id find_or_insert(uint64_t h, Same same, Make make);
+
+  void grow();
+};
+
+template <typename Same>
+id id_table::find(uint64_t h, Same same) const {
+  size_t mask = slots.size() - 1;
+  for (size_t i = h & mask; slots[i].second != none; i = (i + 1) & mask)
+    if (slots[i].first == h && same(slots[i].second))
+      return slots[i].second;
+  return none;
+}
+
+template <typename Same, typename Make>
+id id_table::find_or_insert(uint64_t h, Same same, Make make) {
+  size_t mask = slots.size() - 1;
+  size_t i;
+  for (i = h & mask; slots[i].second != none; i = (i + 1) & mask)
+    if (slots[i].first == h && same(slots[i].second))
+      return slots[i].second;
+  id result = make();
+  slots[i] = { h, result };
+  if (2 * ++count > slots.size())
+    grow();
+  return result;
+}
+
+void id_table::grow() {
+  vector<pair<uint64_t, id>> old(2 * slots.size(), { 0, none });
+  swap(old, slots);
+  size_t mask = slots.size() - 1;
+  for (auto const &slot : old)
+    if (slot.second != none) {
+      size_t i;
+      for (i = slot.first & mask; slots[i].second != none; i = (i + 1) & mask)
+        ;
+      slots[i] = slot;
+    }
+}
+
+uint64_t hash_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+// FNV-1a
+uint64_t hash_name(string_view name) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (unsigned char c : name)
+    h = (h ^ c) * 0x100000001b3ull;
+  return h;
+}
+
+struct file_system {
+  // All the names, back to back
+  string pool;
+  // Name i is pool[name_start[i], name_start[i+1])
+  vector<uint32_t> name_start{0};
+  id_table names;
+
+  // Per-inode data.  Size is for files, 0 for directories.  Total is
+  // the size of the whole subtree, except that directories still open
+  // haven't heard about their open subdirectories yet.  Passed is how
+  // much of total is already included in the parent's.
+  vector<id> parent{none};
+  vector<id> name{none};
+  vector<size_t> size{0};
+  vector<size_t> total{0};
+  vector<size_t> passed{0};
+  id_table entries;
+
+  // Directories from root down to the current one
+  vector<id> open{0};
+
+  bool is_directory(id i) const { return size[i] == 0; }
+
+  string_view name_of(id n) const {
+    return string_view(pool).substr(name_start[n],
+                                    name_start[n + 1] - name_start[n]);
+  }
+
+  id intern(string_view s);
+
+  uint64_t entry_hash(id dir, id n) const {
+    return hash_mix((uint64_t(dir) << 32) | n);
+  }
+
+  // Find (or create if new) a directory entry with the specified size
+  id entry(id dir, string_view entry_name, size_t entry_size = 0);
+
+  // Go into a subdirectory of the current one
+  void enter(id dir) { open.push_back(dir); }
+
+  // Go back up to the parent, passing up any new total
+  void leave();
+
+  // Leave everything except root, e.g., for cd / or at the end
+  void leave_all() {
+    while (open.size() > 1)
+      leave();
+  }
+
+  // Look up an absolute path like /a/e, none if it doesn't exist
+  id lookup(string_view path) const;
+
+  string path_of(id i) const;
+
+  // For debugging
+  void print() const;
+};
+
+id file_system::intern(string_view s) {
+  return names.find_or_insert(hash_name(s),
+                              [&](id n) { return name_of(n) == s; },
+                              [&]() {
+                                pool.append(s);
+                                name_start.push_back(pool.length());
+                                return id(name_start.size() - 2);
+                              });
+}
+
+id file_system::entry(id dir, string_view entry_name, size_t entry_size) {
+  id n = intern(entry_name);
+  // If the entry already exists, I assume it's the same
+  return entries.find_or_insert(entry_hash(dir, n),
+                                [&](id i) {
+                                  return parent[i] == dir && name[i] == n;
+                                },
+                                [&]() {
+                                  parent.push_back(dir);
+                                  name.push_back(n);
+                                  size.push_back(entry_size);
+                                  total.push_back(entry_size);
+                                  passed.push_back(entry_size);
+                                  total[dir] += entry_size;
+                                  return id(size.size() - 1);
+                                });
+}
+
+void file_system::leave() {
+  assert(open.size() > 1);
+  id dir = open.back();
+  open.pop_back();
+  total[parent[dir]] += total[dir] - passed[dir];
+  passed[dir] = total[dir];
+}
+
+id file_system::lookup(string_view path) const {
+  id i = 0;
+  while (i != none && !path.empty()) {
+    if (path.front() == '/') {
+      path.remove_prefix(1);
+      continue;
+    }
+    string_view component = path.substr(0, path.find('/'));
+    path.remove_prefix(component.length());
+    id n = names.find(hash_name(component),
+                      [&](id n) { return name_of(n) == component; });
+    if (n == none)
+      return none;
+    i = entries.find(entry_hash(i, n),
+                     [&](id j) { return parent[j] == i && name[j] == n; });
+  }
+  return i;
+}
+
+string file_system::path_of(id i) const {
+  if (i == 0)
+    return "/";
+  string path;
+  for (; i != 0; i = parent[i])
+    path = "/" + string(name_of(name[i])) + path;
+  return path;
+}
+
+void file_system::print() const {
+  // Gather children to print in tree order
+  vector<vector<id>> children(size.size());
+  for (id i = 1; i < size.size(); ++i)
+    children[parent[i]].push_back(i);
+  vector<pair<id, unsigned>> stack{{ 0, 0 }};
+  while (!stack.empty()) {
+    auto [i, depth] = stack.back();
+    stack.pop_back();
+    cout << string(2 * depth, ' ') << (i == 0 ? "/" : name_of(name[i]));
+    if (is_directory(i))
+      cout << " (dir)\n";
+    else
+      cout << " (file, size=" << size[i] << ")\n";
+    for (auto j = children[i].rbegin(); j != children[i].rend(); ++j)
+      stack.push_back({ *j, depth + 1 });
+  }
+}
+
+// Directories sorted by total size, with running sums so that
+// questions about all directories up to some size don't have to visit
+// each one
+struct size_index {
+  // (total, inode) for each directory, in increasing order
+  vector<pair<size_t, id>> dirs;
+  // sums[i] is the sum of the first i totals
+  vector<size_t> sums{0};
+
+  size_index(file_system const &fs);
+
+  // Number of directories with total <= x; they're the first ones
+  size_t count_at_most(size_t x) const;
+
+  // Sum of directory totals <= x
+  size_t sum_at_most(size_t x) const { return sums[count_at_most(x)]; }
+
+  // Smallest directory with total >= y, none if there isn't one
+  id smallest_at_least(size_t y) const;
+};
+
+size_index::size_index(file_system const &fs) {
+  for (id i = 0; i < fs.size.size(); ++i)
+    if (fs.is_directory(i))
+      dirs.emplace_back(fs.total[i], i);
+  sort(dirs.begin(), dirs.end());
+  for (auto const &dir : dirs)
+    sums.push_back(sums.back() + dir.first);
+}
+
+size_t size_index::count_at_most(size_t x) const {
+  return upper_bound(dirs.begin(), dirs.end(), make_pair(x, none)) -
+    dirs.begin();
+}
+
+id size_index::smallest_at_least(size_t y) const {
+  auto i = lower_bound(dirs.begin(), dirs.end(), make_pair(y, id(0)));
+  return i == dirs.end() ? none : i->second;
+}
+
+// Look for a prefix in the command line
+//    Remove it and return true if found
+//    Leave the line alone and return false otherwise
+bool scan(string_view &line, string_view prefix) {
+  if (line.substr(0, prefix.length()) != prefix)
+    return false;
+  line.remove_prefix(prefix.length());
+  return true;
+}
+
+// Slurp all of stdin in one go
+string read_all() {
+  string input;
+  size_t len = 0;
+  input.resize(1 << 16);
+  size_t n;
+  while ((n = fread(input.data() + len, 1, input.size() - len, stdin)) > 0)
+    if ((len += n) == input.size())
+      input.resize(2 * input.size());
+  input.resize(len);
+  return input;
+}
+
+file_system read() {
+  file_system fs;
+  string input = read_all();
+  string_view rest(input);
+  while (!rest.empty()) {
+    size_t eol = rest.find('\n');
+    string_view line = rest.substr(0, eol);
+    rest.remove_prefix(eol == string_view::npos ? rest.length() : eol + 1);
+    if (line.empty())
+      continue;
+    if (scan(line, "$ cd /")) {
+      // Back to root
+      fs.leave_all();
+    } else if (scan(line, "$ cd ..")) {
+      // Up
+      fs.leave();
+    } else if (scan(line, "$ cd ")) {
+      // line now has the child subdirectory name
+      id dir = fs.entry(fs.open.back(), line);
+      assert(fs.is_directory(dir));
+      fs.enter(dir);
+    } else if (scan(line, "$ ls")) {
+      // List does nothing itself; the entries will populate the file
+      // system
+      ;
+    } else if (scan(line, "dir ")) {
+      // line now has the name of a directory
+      fs.entry(fs.open.back(), line);
+    } else {
+      // Regular file
+      size_t size = 0;
+      while (!line.empty() && isdigit(line.front())) {
+        size = 10 * size + (line.front() - '0');
+        line.remove_prefix(1);
+      }
+      assert(size > 0 && line.length() > 1 && line.front() == ' ');
+      line.remove_prefix(1);
+      fs.entry(fs.open.back(), line, size);
+    }
+  }
+  // Anything still open gets passed up too
+  fs.leave_all();
+  return fs;
+}
+
+void part1() {
+  auto fs = read();
+  size_index index(fs);
+  cout << index.sum_at_most(100000) << '\n';
+}
+
+void part2() {
+  auto fs = read();
+  size_index index(fs);
+  size_t const total_disk = 70000000;
+  size_t const required = 30000000;
+  size_t used = fs.total[0];
+  size_t free = total_disk - used;
+  assert(free < required);
+  // Can always rm -rf /, so this will find something
+  id ans = index.smallest_at_least(required - free);
+  assert(ans != none);
+  cout << fs.total[ans] << '\n';
+}
+
+void query(string const &what, string const &arg) {
+  auto fs = read();
+  size_index index(fs);
+  if (what == "le") {
+    size_t n = index.count_at_most(stoul(arg));
+    for (size_t i = 0; i < n; ++i)
+      cout << index.dirs[i].first << ' '
+           << fs.path_of(index.dirs[i].second) << '\n';
+  } else if (what == "ge") {
+    id i = index.smallest_at_least(stoul(arg));
+    if (i != none)
+      cout << fs.total[i] << ' ' << fs.path_of(i) << '\n';
+  } else {
+    assert(what == "size");
+    id i = fs.lookup(arg);
+    if (i != none)
+      cout << fs.total[i] << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2 && argc != 3) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " le|ge|size arg < input\n";
+    exit(1);
+  }
+  if (argc == 3)
+    query(argv[1], argv[2]);
+  else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
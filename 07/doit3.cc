@@ -0,0 +1,128 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit3 doit3.cc
+// ./doit3 1 < input  # part 1
+// ./doit3 2 < input  # part 2
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+
+// Streaming version of doit1.cc that never holds more than the stack
+// of open directories, so memory is proportional to the depth of the
+// tree rather than its size, no matter how long the log is.
+//
+// Part 1 only needs each directory's size as it's completed.  Part 2
+// needs the root total before it knows which directories are big
+// enough, so it takes two passes.  If stdin is a file it's just
+// rewound; if it's a pipe the first pass spools the log to a
+// temporary file for the second pass to read.
+
+// Read a line of any length into line (reusing its storage), without
+// the newline.  Returns false at EOF.
+bool read_line(FILE *fp, string &line) {
+  line.clear();
+  char buf[4096];
+  while (fgets(buf, sizeof(buf), fp)) {
+    size_t len = strlen(buf);
+    if (len > 0 && buf[len - 1] == '\n') {
+      line.append(buf, len - 1);
+      return true;
+    }
+    line.append(buf, len);
+  }
+  return !line.empty();
+}
+
+// Walk the log with a stack of open directories as in doit1.cc,
+// calling process_dir on each directory's size when it's complete.
+// Each line is also copied to spool if that's not null.  Returns the
+// total size of everything.
+size_t walk(FILE *log, FILE *spool,
+            function<void(size_t dir_size)> process_dir) {
+  // Sizes of directories that are being traversed
+  vector<size_t> sizes;
+  size_t used = 0;
+  auto pop_dir = [&]() {
+                   size_t dir_size = sizes.back();
+                   sizes.pop_back();
+                   process_dir(dir_size);
+                   if (!sizes.empty())
+                     sizes.back() += dir_size;
+                 };
+  string line;
+  while (read_line(log, line)) {
+    if (spool) {
+      fputs(line.c_str(), spool);
+      fputc('\n', spool);
+    }
+    if (line == "$ cd ..") {
+      assert(!sizes.empty());
+      pop_dir();
+    } else if (line.compare(0, 5, "$ cd ") == 0) {
+      sizes.push_back(0);
+    } else if (line == "$ ls" || line.compare(0, 4, "dir ") == 0) {
+      ;
+    } else if (!line.empty()) {
+      size_t size = stoul(line);
+      assert(size > 0 && !sizes.empty());
+      sizes.back() += size;
+      used += size;
+    }
+  }
+  while (!sizes.empty())
+    pop_dir();
+  return used;
+}
+
+void part1() {
+  size_t ans = 0;
+  walk(stdin, nullptr, [&](size_t dir_size) {
+                         if (dir_size <= 100000) ans += dir_size;
+                       });
+  cout << ans << '\n';
+}
+
+void part2() {
+  size_t const total_disk = 70000000;
+  size_t const required = 30000000;
+  // First pass just for the root total
+  FILE *log = stdin;
+  bool seekable = fseek(log, 0, SEEK_CUR) == 0;
+  FILE *spool = seekable ? nullptr : tmpfile();
+  assert(seekable || spool);
+  size_t used = walk(log, spool, [](size_t) {});
+  if (seekable)
+    rewind(log);
+  else {
+    rewind(spool);
+    log = spool;
+  }
+  size_t free = total_disk - used;
+  assert(free < required);
+  size_t ans = used;                    // Can always rm -rf /
+  walk(log, nullptr, [&](size_t dir_size) {
+                       if (free + dir_size >= required && dir_size < ans)
+                         ans = dir_size;
+                     });
+  if (spool)
+    fclose(spool);
+  cout << ans << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
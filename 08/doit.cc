@@ -1,16 +1,38 @@
 // -*- C++ -*-
-// g++ -std=c++17 -Wall -g -o doit doit.cc
+// g++ -std=c++17 -Wall -g -pthread -o doit doit.cc
 // ./doit 1 < input  # part 1
 // ./doit 2 < input  # part 2
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <cstdint>
 #include <cassert>
 
 using namespace std;
 
+// Split [0, n) into one band per core and run work(begin, end) on the
+// bands in parallel.  Each band (except maybe the last) is a multiple
+// of grain long.
+void parallel_bands(int n, int grain, function<void(int begin, int end)> work) {
+  size_t num_threads = max(1u, thread::hardware_concurrency());
+  size_t num_grains = (n + grain - 1) / grain;
+  vector<thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    int begin = min<size_t>(n, num_grains * t / num_threads * grain);
+    int end = min<size_t>(n, num_grains * (t + 1) / num_threads * grain);
+    if (begin < end)
+      threads.emplace_back(work, begin, end);
+  }
+  for (auto &th : threads)
+    th.join();
+}
+
 struct trees {
   vector<string> tree_heights;
 
@@ -34,7 +56,13 @@ struct trees {
   // times, with (i, j) starting from a point on an edge, and (di, dj)
   // indicating the direction to scan.  Do i += di; j += dj; to scan
   // over the row / column.
-  void scan4(function<void(int i, int j, int di, int dj)> scan) const;
+  //
+  // The rows are scanned in parallel in bands, and then the columns.
+  // Column bands are multiples of col_grain columns wide, so a scan
+  // that writes per-tree data can keep different threads off of each
+  // other's cache lines.
+  void scan4(function<void(int i, int j, int di, int dj)> scan,
+             int col_grain = 1) const;
 };
 
 trees::trees() {
@@ -45,65 +73,157 @@ trees::trees() {
   }
 }
 
-void trees::scan4(function<void(int i, int j, int di, int dj)> scan) const {
-  for (int i = 0; i < h(); ++i) {
-    scan(i,       0, 0,  1);
-    scan(i, w() - 1, 0, -1);
-  }
-  for (int j = 0; j < w(); ++j) {
-    scan(      0, j,  1, 0);
-    scan(h() - 1, j, -1, 0);
-  }
+void trees::scan4(function<void(int i, int j, int di, int dj)> scan,
+                  int col_grain) const {
+  parallel_bands(h(), 1, [&](int begin, int end) {
+                           for (int i = begin; i < end; ++i) {
+                             scan(i,       0, 0,  1);
+                             scan(i, w() - 1, 0, -1);
+                           }
+                         });
+  parallel_bands(w(), col_grain, [&](int begin, int end) {
+                                   for (int j = begin; j < end; ++j) {
+                                     scan(      0, j,  1, 0);
+                                     scan(h() - 1, j, -1, 0);
+                                   }
+                                 });
 }
 
 void part1() {
   trees ts;
-  vector<vector<bool>> visible(ts.h(), vector<bool>(ts.w(), false));
+  // One bit per tree, row-major.  Rows are padded to a whole number of
+  // cache lines, so threads scanning different rows or different
+  // line-sized bands of columns never write to the same line.
+  struct alignas(64) cache_line { uint64_t bits[8]; };
+  int const line_bits = 8 * sizeof(cache_line);
+  size_t row_lines = (ts.w() + line_bits - 1) / line_bits;
+  vector<cache_line> visible(ts.h() * row_lines, cache_line{});
   ts.scan4([&](int i, int j, int di, int dj) {
              char max_height = '0' - 1;
              while (char t = ts.at(i, j)) {
-               if (t > max_height)
-                 visible[i][j] = true;
+               if (t > max_height) {
+                 auto &line = visible[i * row_lines + j / line_bits];
+                 line.bits[j % line_bits / 64] |= uint64_t(1) << (j % 64);
+               }
                max_height = max(max_height, t);
                i += di;
                j += dj;
              }
-           });
-  unsigned ans = 0;
-  for (int i = 0; i < ts.h(); ++i)
-    for (int j = 0; j < ts.w(); ++j)
-      ans += visible[i][j];
+           }, line_bits);
+  size_t ans = 0;
+  for (auto const &line : visible)
+    for (auto bits : line.bits)
+      ans += __builtin_popcountll(bits);
   cout << ans << '\n';
 }
 
+// Rather than storing a score per tree, go row by row and finish each
+// tree's score as soon as all four directions are known, keeping only
+// the max.
+//   Left and right come from scanning the row itself.
+//   Up is like the part 1 scans: each column keeps the number of trees
+//   a tree of each height can see upwards.
+//   Down isn't known until a tree at least as tall turns up below (or
+//   the edge is reached).  Each column keeps a stack of trees still
+//   waiting for that, with their partial scores.  A new tree finishes
+//   all the waiting trees that are no taller, so the stack's heights
+//   are strictly decreasing and it never has more than 10 entries.
+// So aside from the heights, memory is proportional to the width.
+//
+// This handles a band of rows [i0, i1), so that bands can run in
+// parallel.  The column state going into the band comes from looking
+// up each column until a 9 (or the edge), and trees still waiting at
+// the end of the band look down past it until they're finished.
+uint64_t scenic_max(trees const &ts, int i0, int i1) {
+  int const num_heights = 10;
+  struct waiting {
+    char height;
+    int i;
+    uint64_t score;
+  };
+  vector<array<unsigned, num_heights>> up_seen(ts.w());
+  vector<array<waiting, num_heights>> down_waiting(ts.w());
+  vector<int> num_waiting(ts.w(), 0);
+  vector<uint64_t> row_score(ts.w());
+  uint64_t ans = 0;
+  // Trees of <= t can't see farther than a tree of height t, trees
+  // of > t can see it in addition to what they could see before
+  auto update = [&](unsigned *num_seen, int t) {
+                  for (int small = 0; small <= t; ++small)
+                    num_seen[small] = 1;
+                  for (int big = t + 1; big < num_heights; ++big)
+                    ++num_seen[big];
+                };
+  auto finish = [&](int j, int i) {
+                  auto const &w = down_waiting[j][--num_waiting[j]];
+                  ans = max(ans, w.score * (i - w.i));
+                };
+  // A tree of height t at row i0 sees up to the first tree >= t, or
+  // all i0 trees to the edge
+  for (int j = 0; j < ts.w(); ++j) {
+    auto &num_seen = up_seen[j];
+    int t = 0;
+    for (int i = i0 - 1; i >= 0 && t < num_heights; --i)
+      for (int above = ts.at(i, j) - '0'; t <= above; ++t)
+        num_seen[t] = i0 - i;
+    for (; t < num_heights; ++t)
+      num_seen[t] = i0;
+  }
+  for (int i = i0; i < i1; ++i) {
+    array<unsigned, num_heights> num_seen;
+    // Left
+    fill(num_seen.begin(), num_seen.end(), 0);
+    for (int j = 0; j < ts.w(); ++j) {
+      char t = ts.at(i, j) - '0';
+      assert(0 <= t && t < num_heights);
+      row_score[j] = num_seen[t];
+      update(num_seen.data(), t);
+    }
+    // Right
+    fill(num_seen.begin(), num_seen.end(), 0);
+    for (int j = ts.w() - 1; j >= 0; --j) {
+      char t = ts.at(i, j) - '0';
+      row_score[j] *= num_seen[t];
+      update(num_seen.data(), t);
+    }
+    for (int j = 0; j < ts.w(); ++j) {
+      char t = ts.at(i, j) - '0';
+      // Up
+      row_score[j] *= up_seen[j][t];
+      update(up_seen[j].data(), t);
+      // This tree ends the view down from waiting trees that are no
+      // taller, then starts waiting itself
+      while (num_waiting[j] > 0 &&
+             down_waiting[j][num_waiting[j] - 1].height <= t)
+        finish(j, i);
+      down_waiting[j][num_waiting[j]++] = { t, i, row_score[j] };
+    }
+  }
+  // Keep going below the band for anything still waiting; whatever's
+  // left after that can see to the bottom edge
+  for (int j = 0; j < ts.w(); ++j) {
+    for (int i = i1; i < ts.h() && num_waiting[j] > 0; ++i) {
+      char t = ts.at(i, j) - '0';
+      while (num_waiting[j] > 0 &&
+             down_waiting[j][num_waiting[j] - 1].height <= t)
+        finish(j, i);
+    }
+    while (num_waiting[j] > 0)
+      finish(j, ts.h() - 1);
+  }
+  return ans;
+}
+
 void part2() {
   trees ts;
-  vector<vector<unsigned>> scenic_score(ts.h(), vector<unsigned>(ts.w(), 1));
-  ts.scan4([&](int i, int j, int di, int dj) {
-             // num_seen[t] = number of trees that can be seen from a
-             // tree of height t (0-indexed, i.e., subtract '0').
-             // This starts at 0 for an edge.
-             int const num_heights = 10;
-             vector<unsigned> num_seen(num_heights, 0);
-             while (char t = ts.at(i, j)) {
-               t -= '0';
-               assert(t < num_heights);
-               scenic_score[i][j] *= num_seen[t];
-               // Trees of <= t can't see farther than this tree
-               for (char small = 0; small <= t; ++small)
-                 num_seen[small] = 1;
-               // Trees of > t can see this tree in addition to what
-               // they could see before
-               for (char big = t + 1; big < num_heights; ++big)
-                 ++num_seen[big];
-               i += di;
-               j += dj;
-             }
-           });
-  unsigned ans = 0;
-  for (int i = 0; i < ts.h(); ++i)
-    for (int j = 0; j < ts.w(); ++j)
-      ans = max(ans, scenic_score[i][j]);
+  // Bands only touch this once at the end
+  mutex ans_mutex;
+  uint64_t ans = 0;
+  parallel_bands(ts.h(), 1, [&](int begin, int end) {
+                              uint64_t band_ans = scenic_max(ts, begin, end);
+                              lock_guard<mutex> lock(ans_mutex);
+                              ans = max(ans, band_ans);
+                            });
   cout << ans << '\n';
 }
 
@@ -0,0 +1,159 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -O3 -march=native -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+using namespace std;
+
+// Same scans as doit.cc, but arranged so that everything reads
+// memory in order, for big forests.  The heights are in one flat
+// row-major array, so the left/right sweeps along a row are
+// contiguous.  The up/down sweeps are done for a tile of adjacent
+// columns at a time: each step reads a short contiguous run from the
+// next row and updates the state for all of the tile's columns at
+// once.  The per-column loops are simple enough for the compiler to
+// vectorize.
+
+// Columns per tile
+int const tile = 32;
+// Heights are stored as 1..10 so that 0 can mean "nothing yet"
+int const num_heights = 10;
+
+struct trees {
+  int w{0};
+  int h{0};
+  vector<uint8_t> heights;
+
+  trees();
+
+  size_t index(int i, int j) const { return size_t(i) * w + j; }
+
+  // Call row(i, left_to_right) for each row and direction, then
+  // cols(i0, di, j0, nj) for tiles of columns [j0, j0+nj), where the
+  // scan starts at row i0 and goes in direction di
+  template <typename Row, typename Cols>
+  void scan4(Row row, Cols cols) const;
+};
+
+trees::trees() {
+  string line;
+  while (getline(cin, line)) {
+    if (w == 0)
+      w = line.length();
+    assert(int(line.length()) == w);
+    for (char c : line) {
+      assert('0' <= c && c <= '9');
+      heights.push_back(c - '0' + 1);
+    }
+    ++h;
+  }
+}
+
+template <typename Row, typename Cols>
+void trees::scan4(Row row, Cols cols) const {
+  for (int i = 0; i < h; ++i) {
+    row(i, true);
+    row(i, false);
+  }
+  for (int j0 = 0; j0 < w; j0 += tile) {
+    int nj = min(tile, w - j0);
+    cols(0, 1, j0, nj);
+    cols(h - 1, -1, j0, nj);
+  }
+}
+
+void part1() {
+  trees ts;
+  vector<uint8_t> visible(ts.heights.size(), 0);
+  ts.scan4([&](int i, bool left_to_right) {
+             uint8_t const *t = &ts.heights[ts.index(i, 0)];
+             uint8_t *vis = &visible[ts.index(i, 0)];
+             uint8_t max_height = 0;
+             for (int k = 0; k < ts.w; ++k) {
+               int j = left_to_right ? k : ts.w - 1 - k;
+               vis[j] |= t[j] > max_height;
+               max_height = max(max_height, t[j]);
+             }
+           },
+           [&](int i, int di, int j0, int nj) {
+             array<uint8_t, tile> max_height;
+             fill(max_height.begin(), max_height.end(), 0);
+             for (int n = 0; n < ts.h; ++n, i += di) {
+               uint8_t const *t = &ts.heights[ts.index(i, j0)];
+               uint8_t *vis = &visible[ts.index(i, j0)];
+               for (int k = 0; k < nj; ++k) {
+                 vis[k] |= t[k] > max_height[k];
+                 max_height[k] = max(max_height[k], t[k]);
+               }
+             }
+           });
+  size_t ans = 0;
+  for (auto v : visible)
+    ans += v;
+  cout << ans << '\n';
+}
+
+void part2() {
+  trees ts;
+  vector<uint64_t> scenic_score(ts.heights.size(), 1);
+  // num_seen[t] = number of trees that can be seen from a tree of
+  // height t, as in doit.cc, but heights here are 1-based.  Update it
+  // for a tree of height t.
+  auto update = [](uint32_t &num_seen, int height, uint8_t t) {
+                  // Trees of <= t can't see farther than this tree,
+                  // trees of > t can see one more
+                  num_seen = height <= t ? 1 : num_seen + 1;
+                };
+  ts.scan4([&](int i, bool left_to_right) {
+             uint8_t const *t = &ts.heights[ts.index(i, 0)];
+             uint64_t *score = &scenic_score[ts.index(i, 0)];
+             array<uint32_t, num_heights + 1> num_seen;
+             fill(num_seen.begin(), num_seen.end(), 0);
+             for (int k = 0; k < ts.w; ++k) {
+               int j = left_to_right ? k : ts.w - 1 - k;
+               score[j] *= num_seen[t[j]];
+               for (int height = 1; height <= num_heights; ++height)
+                 update(num_seen[height], height, t[j]);
+             }
+           },
+           [&](int i, int di, int j0, int nj) {
+             // One row of counters per height, one column per tile
+             // column, so the inner loops run across the tile
+             array<array<uint32_t, tile>, num_heights + 1> num_seen;
+             for (auto &by_col : num_seen)
+               fill(by_col.begin(), by_col.end(), 0);
+             for (int n = 0; n < ts.h; ++n, i += di) {
+               uint8_t const *t = &ts.heights[ts.index(i, j0)];
+               uint64_t *score = &scenic_score[ts.index(i, j0)];
+               for (int k = 0; k < nj; ++k)
+                 score[k] *= num_seen[t[k]][k];
+               for (int height = 1; height <= num_heights; ++height)
+                 for (int k = 0; k < nj; ++k)
+                   update(num_seen[height][k], height, t[k]);
+             }
+           });
+  uint64_t ans = 0;
+  for (auto score : scenic_score)
+    ans = max(ans, score);
+  cout << ans << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -0,0 +1,137 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit2 doit2.cc
+// ./doit2 1 < input  # part 1
+// ./doit2 2 < input  # part 2
+//
+// Input rows can be digits as in the puzzle, or whitespace-separated
+// heights from 0 to 65535
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+using namespace std;
+
+// doit.cc's scenic scan keeps a counter for every height, so it only
+// works when there are just a few heights.  This version uses a
+// monotonic stack of (height, position) for the trees that could
+// still block the view, which costs amortized O(1) per tree for any
+// number of heights.
+struct trees {
+  int w{0};
+  int h{0};
+  // Row-major
+  vector<uint16_t> heights;
+
+  trees();
+
+  bool valid(int i, int j) const {
+    return i >= 0 && i < h && j >= 0 && j < w;
+  }
+
+  uint16_t at(int i, int j) const {
+    assert(valid(i, j));
+    return heights[size_t(i) * w + j];
+  }
+
+  // Scan from all four edges, see doit.cc
+  void scan4(function<void(int i, int j, int di, int dj)> scan) const;
+};
+
+trees::trees() {
+  string line;
+  while (getline(cin, line)) {
+    vector<unsigned> row;
+    if (line.find_first_of(" \t") == string::npos)
+      for (char c : line) {
+        assert('0' <= c && c <= '9');
+        row.push_back(c - '0');
+      }
+    else {
+      istringstream in(line);
+      unsigned height;
+      while (in >> height)
+        row.push_back(height);
+    }
+    if (h == 0)
+      w = row.size();
+    assert(int(row.size()) == w);
+    for (auto height : row) {
+      assert(height <= UINT16_MAX);
+      heights.push_back(height);
+    }
+    ++h;
+  }
+}
+
+void trees::scan4(function<void(int i, int j, int di, int dj)> scan) const {
+  for (int i = 0; i < h; ++i) {
+    scan(i,     0, 0,  1);
+    scan(i, w - 1, 0, -1);
+  }
+  for (int j = 0; j < w; ++j) {
+    scan(    0, j,  1, 0);
+    scan(h - 1, j, -1, 0);
+  }
+}
+
+void part1() {
+  trees ts;
+  vector<bool> visible(ts.heights.size(), false);
+  ts.scan4([&](int i, int j, int di, int dj) {
+             int max_height = -1;
+             while (ts.valid(i, j)) {
+               int t = ts.at(i, j);
+               if (t > max_height)
+                 visible[size_t(i) * ts.w + j] = true;
+               max_height = max(max_height, t);
+               i += di;
+               j += dj;
+             }
+           });
+  cout << count(visible.begin(), visible.end(), true) << '\n';
+}
+
+void part2() {
+  trees ts;
+  vector<uint64_t> scenic_score(ts.heights.size(), 1);
+  ts.scan4([&](int i, int j, int di, int dj) {
+             // Trees already passed that might block the view back
+             // toward the edge, as (height, distance from edge).
+             // Heights are strictly decreasing going up the stack.
+             vector<pair<uint16_t, int>> blockers;
+             for (int pos = 0; ts.valid(i, j); ++pos) {
+               uint16_t t = ts.at(i, j);
+               // Shorter trees are seen past, and since this tree is
+               // in front of them, they won't block anything later
+               while (!blockers.empty() && blockers.back().first < t)
+                 blockers.pop_back();
+               int seen = blockers.empty() ? pos : pos - blockers.back().second;
+               scenic_score[size_t(i) * ts.w + j] *= seen;
+               // An equal tree is also hidden behind this one now
+               if (!blockers.empty() && blockers.back().first == t)
+                 blockers.pop_back();
+               blockers.emplace_back(t, pos);
+               i += di;
+               j += dj;
+             }
+           });
+  cout << *max_element(scenic_score.begin(), scenic_score.end()) << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -2,11 +2,14 @@
 // g++ -std=c++17 -Wall -g -o doit doit.cc
 // ./doit 1 < input  # part 1
 // ./doit 2 < input  # part 2
+// ./doit N < input  # all rope lengths 2..N at once
 
 #include <iostream>
 #include <vector>
-#include <set>
+#include <array>
 #include <utility>
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cassert>
 
@@ -17,8 +20,8 @@ struct knot_pos: pair<int, int> {
   knot_pos(int x = 0, int y = 0) : pair<int, int>(x, y) {}
   // Take a step in the given direction
   void step(char dir);
-  // Follow another knot_pos
-  void follow(knot_pos const &pos);
+  // Follow another knot_pos, returns true if this knot moved
+  bool follow(knot_pos const &pos);
 };
 
 void knot_pos::step(char dir) {
@@ -32,52 +35,224 @@ void knot_pos::step(char dir) {
   }
 }
 
-void knot_pos::follow(knot_pos const &pos) {
+bool knot_pos::follow(knot_pos const &pos) {
   int dx = pos.first - first;
   int dy = pos.second - second;
   if (abs(dx) <= 1 && abs(dy) <= 1)
     // Close enough that no movement is needed
-    return;
+    return false;
   auto ketchup = [](int d) { return d == 0 ? 0 : (d > 0 ? +1 : -1); };
   first += ketchup(dx);
   second += ketchup(dy);
   assert(abs(pos.first - first) <= 1 && abs(pos.second - second) <= 1);
+  return true;
+}
+
+// The set of positions a knot has visited.  While the explored area is
+// small, it's a bitmap made of 64x64 tiles that get allocated as the
+// rope wanders into them.  If the bounding box of the tiles gets too
+// big, it switches to an open-addressed hash set of positions packed
+// into 64 bits.
+struct position_tracker {
+  // Number of distinct positions
+  size_t count{0};
+  bool dense{true};
+
+  // Dense mode: the box of tiles [tx0, tx0 + tw) x [ty0, ty0 + th),
+  // with tile_index giving the position in tiles of each allocated
+  // tile in the box
+  static constexpr int tile_bits = 6;
+  static constexpr int tile_size = 1 << tile_bits;
+  static constexpr size_t max_box_tiles = 1 << 16;
+  static constexpr uint32_t no_tile = ~uint32_t(0);
+  int tx0{0}, ty0{0}, tw{0}, th{0};
+  vector<uint32_t> tile_index;
+  vector<array<uint64_t, tile_size>> tiles;
+
+  // Sparse mode: a table of packed positions
+  static constexpr uint64_t empty = 0x8000000080000000ull;
+  vector<uint64_t> slots;
+  size_t num_used{0};
+
+  // Add a position
+  void insert(knot_pos const &pos);
+
+  size_t size() const { return count; }
+
+  // Dense mode helpers
+  void grow_box(int tx, int ty);
+  void go_sparse();
+
+  // Sparse mode helpers
+  static uint64_t pack(int x, int y) {
+    return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+  }
+  bool sparse_insert(uint64_t key);
+};
+
+void position_tracker::insert(knot_pos const &pos) {
+  int x = pos.first;
+  int y = pos.second;
+  // Arithmetic shift, so this rounds down for negative coordinates
+  int tx = x >> tile_bits;
+  int ty = y >> tile_bits;
+  if (dense && (tx < tx0 || tx >= tx0 + tw || ty < ty0 || ty >= ty0 + th))
+    grow_box(tx, ty);
+  if (!dense) {
+    count += sparse_insert(pack(x, y));
+    return;
+  }
+  uint32_t &index = tile_index[size_t(ty - ty0) * tw + tx - tx0];
+  if (index == no_tile) {
+    index = tiles.size();
+    tiles.emplace_back();
+    tiles.back().fill(0);
+  }
+  uint64_t &row = tiles[index][y & (tile_size - 1)];
+  uint64_t bit = uint64_t(1) << (x & (tile_size - 1));
+  count += (row & bit) == 0;
+  row |= bit;
+}
+
+// Extend the box to cover tile (tx, ty), at least doubling in the
+// direction of growth so that growing is amortized
+void position_tracker::grow_box(int tx, int ty) {
+  int nx0 = tx0, ny0 = ty0, nw = tw, nh = th;
+  if (tw == 0) {
+    nx0 = tx;
+    ny0 = ty;
+    nw = nh = 1;
+  }
+  if (tx < nx0) {
+    int grow = max(nx0 - tx, nw);
+    nx0 -= grow;
+    nw += grow;
+  } else if (tx >= nx0 + nw)
+    nw += max(tx - (nx0 + nw) + 1, nw);
+  if (ty < ny0) {
+    int grow = max(ny0 - ty, nh);
+    ny0 -= grow;
+    nh += grow;
+  } else if (ty >= ny0 + nh)
+    nh += max(ty - (ny0 + nh) + 1, nh);
+  if (size_t(nw) * nh > max_box_tiles) {
+    go_sparse();
+    return;
+  }
+  vector<uint32_t> new_index(size_t(nw) * nh, no_tile);
+  for (int j = 0; j < th; ++j)
+    for (int i = 0; i < tw; ++i)
+      new_index[size_t(ty0 - ny0 + j) * nw + tx0 - nx0 + i] =
+        tile_index[size_t(j) * tw + i];
+  tile_index.swap(new_index);
+  tx0 = nx0;
+  ty0 = ny0;
+  tw = nw;
+  th = nh;
+}
+
+void position_tracker::go_sparse() {
+  dense = false;
+  slots.assign(1 << 16, empty);
+  for (int j = 0; j < th; ++j)
+    for (int i = 0; i < tw; ++i) {
+      uint32_t index = tile_index[size_t(j) * tw + i];
+      if (index == no_tile)
+        continue;
+      auto const &tile = tiles[index];
+      for (int y = 0; y < tile_size; ++y)
+        for (int x = 0; x < tile_size; ++x)
+          if (tile[y] & (uint64_t(1) << x))
+            sparse_insert(pack(((tx0 + i) << tile_bits) + x,
+                               ((ty0 + j) << tile_bits) + y));
+    }
+  tile_index = vector<uint32_t>();
+  tiles = vector<array<uint64_t, tile_size>>();
 }
 
-void rope_sim(int num_knots) {
+// Returns true if the key is new
+bool position_tracker::sparse_insert(uint64_t key) {
+  assert(key != empty);
+  auto slot_for = [&](uint64_t key) {
+                    // Murmur3 finalizer to spread the bits
+                    uint64_t h = key;
+                    h ^= h >> 33;
+                    h *= 0xff51afd7ed558ccdull;
+                    h ^= h >> 33;
+                    size_t mask = slots.size() - 1;
+                    size_t i;
+                    for (i = h & mask; slots[i] != empty && slots[i] != key;
+                         i = (i + 1) & mask)
+                      ;
+                    return i;
+                  };
+  size_t i = slot_for(key);
+  if (slots[i] == key)
+    return false;
+  slots[i] = key;
+  if (2 * ++num_used > slots.size()) {
+    vector<uint64_t> old(2 * slots.size(), empty);
+    old.swap(slots);
+    for (auto k : old)
+      if (k != empty)
+        slots[slot_for(k)] = k;
+  }
+  return true;
+}
+
+// Knot k of a rope moves exactly like the tail of a rope with k+1
+// knots, so one simulation answers every shorter rope too.  This
+// returns the number of positions visited by each knot; entry k-1 is
+// the answer for a rope of length k.  Tracking every knot costs a lot
+// more than tracking just the tail, though, so unless every_knot is
+// set, only the tail's entry is filled in.
+vector<size_t> rope_sim(int num_knots, bool every_knot = false) {
   assert(num_knots >= 2);
   // The rope
   vector<knot_pos> rope(num_knots);
   knot_pos &head = rope.front();
-  knot_pos &tail = rope.back();
-  // Where the tail has been
-  set<knot_pos> tail_positions;
-  tail_positions.emplace(tail);
+  // Where each knot has been
+  vector<position_tracker> positions(num_knots);
+  size_t first_tracked = every_knot ? 1 : num_knots - 1;
+  for (size_t i = first_tracked; i < rope.size(); ++i)
+    positions[i].insert(rope[i]);
   // Simulate
   char dir;
   int num_steps;
   while (cin >> dir >> num_steps) {
     for (int _ = 0; _ < num_steps; ++_) {
       head.step(dir);
-      // Drag each knot after the previous one
-      for (size_t i = 1; i < rope.size(); ++i)
-        rope[i].follow(rope[i - 1]);
-      tail_positions.emplace(tail);
+      // Drag each knot after the previous one.  Once one stays put,
+      // so does everything behind it.
+      for (size_t i = 1; i < rope.size() && rope[i].follow(rope[i - 1]); ++i)
+        if (i >= first_tracked)
+          positions[i].insert(rope[i]);
     }
   }
-  cout << tail_positions.size() << '\n';
+  vector<size_t> visited;
+  for (auto const &knot_positions : positions)
+    visited.push_back(knot_positions.size());
+  return visited;
 }
 
-void part1() { rope_sim(2); }
+void part1() { cout << rope_sim(2).back() << '\n'; }
+
+void part2() { cout << rope_sim(10).back() << '\n'; }
 
-void part2() { rope_sim(10); }
+void all_lengths(int num_knots) {
+  auto visited = rope_sim(num_knots, true);
+  for (int k = 2; k <= num_knots; ++k)
+    cout << k << ": " << visited[k - 1] << '\n';
+}
 
 int main(int argc, char **argv) {
   if (argc != 2) {
     cerr << "usage: " << argv[0] << " partnum < input\n";
     exit(1);
   }
-  if (*argv[1] == '1')
+  if (atoi(argv[1]) > 2)
+    all_lengths(atoi(argv[1]));
+  else if (*argv[1] == '1')
     part1();
   else
     part2();
@@ -0,0 +1,126 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+// ./doit1 N < input  # rope with N > 2 knots
+
+#include <iostream>
+#include <vector>
+#include <unordered_set>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+
+// A version of doit.cc for very long ropes and very long moves.  Two
+// things keep it from doing steps * knots work:
+//   Propagation down the rope stops at the first knot that doesn't
+//   move, since nothing behind it will move either.
+//   Once the whole rope is a straight line pointing along the
+//   direction of movement, each further step just moves every knot
+//   one more unit that way, so the rest of the move is done in one
+//   jump (the tail's path still gets recorded).
+
+struct knot_pos: pair<int, int> {
+  knot_pos(int x = 0, int y = 0) : pair<int, int>(x, y) {}
+  // Take a step in the given direction
+  void step(char dir);
+  // Follow another knot_pos, returns true if this knot moved
+  bool follow(knot_pos const &pos);
+};
+
+void knot_pos::step(char dir) {
+  switch (dir) {
+  case 'L':  --first; break;
+  case 'R':  ++first; break;
+  case 'U': ++second; break;
+  case 'D': --second; break;
+  default:
+    assert(dir == 'L' || dir == 'R' || dir == 'U' || dir == 'D');
+  }
+}
+
+bool knot_pos::follow(knot_pos const &pos) {
+  int dx = pos.first - first;
+  int dy = pos.second - second;
+  if (abs(dx) <= 1 && abs(dy) <= 1)
+    // Close enough that no movement is needed
+    return false;
+  auto ketchup = [](int d) { return d == 0 ? 0 : (d > 0 ? +1 : -1); };
+  first += ketchup(dx);
+  second += ketchup(dy);
+  assert(abs(pos.first - first) <= 1 && abs(pos.second - second) <= 1);
+  return true;
+}
+
+uint64_t pack(knot_pos const &pos) {
+  return (uint64_t(uint32_t(pos.first)) << 32) | uint32_t(pos.second);
+}
+
+void rope_sim(int num_knots) {
+  assert(num_knots >= 2);
+  vector<knot_pos> rope(num_knots);
+  knot_pos &head = rope.front();
+  knot_pos &tail = rope.back();
+  unordered_set<uint64_t> tail_positions;
+  tail_positions.insert(pack(tail));
+  char dir;
+  int num_steps;
+  while (cin >> dir >> num_steps) {
+    knot_pos d;
+    d.step(dir);
+    // Is knot i directly behind knot i-1?
+    auto in_line = [&](size_t i) {
+                     return rope[i].first == rope[i - 1].first - d.first &&
+                       rope[i].second == rope[i - 1].second - d.second;
+                   };
+    int step = 0;
+    while (step < num_steps) {
+      head.step(dir);
+      ++step;
+      bool straight = true;
+      size_t i;
+      for (i = 1; i < rope.size() && rope[i].follow(rope[i - 1]); ++i)
+        straight = straight && in_line(i);
+      if (i == rope.size()) {
+        tail_positions.insert(pack(tail));
+        if (straight)
+          break;
+      }
+    }
+    // Any remaining steps are with a straight rope (or there'd be
+    // none), so jump ahead
+    int rest = num_steps - step;
+    if (rest > 0) {
+      for (auto &knot : rope) {
+        knot.first += rest * d.first;
+        knot.second += rest * d.second;
+      }
+      for (int k = rest - 1; k >= 0; --k)
+        tail_positions.insert(pack(knot_pos(tail.first - k * d.first,
+                                            tail.second - k * d.second)));
+    }
+  }
+  cout << tail_positions.size() << '\n';
+}
+
+void part1() { rope_sim(2); }
+
+void part2() { rope_sim(10); }
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  int n = atoi(argv[1]);
+  if (n > 2)
+    rope_sim(n);
+  else if (n == 1)
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -0,0 +1,179 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit2 doit2.cc
+// ./doit2 1 < input  # part 1
+// ./doit2 2 < input  # part 2
+// ./doit2 q cycle... < input  # X during each given cycle
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+
+using namespace std;
+
+// Instead of recording X for every cycle, compile the program into a
+// run-length trace: X only changes after an addx with a nonzero
+// delta, so keep just the cycles where it changes.  Looking up X for
+// a cycle is then a binary search, and the CRT can be drawn a span of
+// constant X at a time.
+
+// Minimal buffered reader for stdin, since the programs can be huge
+struct reader {
+  array<char, 65536> buf;
+  size_t pos{0};
+  size_t len{0};
+
+  // Next character, or EOF
+  int get() {
+    if (pos == len) {
+      len = fread(buf.data(), 1, buf.size(), stdin);
+      pos = 0;
+      if (len == 0)
+        return EOF;
+    }
+    return (unsigned char)buf[pos++];
+  }
+
+  // Skip to the next line
+  void skip_line() {
+    int c;
+    while ((c = get()) != EOF && c != '\n')
+      ;
+  }
+
+  // Read an optionally signed integer after skipping spaces
+  long read_int();
+};
+
+long reader::read_int() {
+  int c;
+  while ((c = get()) == ' ')
+    ;
+  bool negative = c == '-';
+  if (negative)
+    c = get();
+  assert(isdigit(c));
+  long n = 0;
+  for (; isdigit(c); c = get())
+    n = 10 * n + (c - '0');
+  assert(c == '\n' || c == EOF);
+  return negative ? -n : n;
+}
+
+struct trace {
+  // X is xs[k] during cycles [starts[k], starts[k+1]), and cycles
+  // are numbered from 1
+  vector<uint64_t> starts{1};
+  vector<int> xs{1};
+  // Number of cycles the program runs
+  uint64_t num_cycles{0};
+
+  // Compile the program on stdin
+  trace();
+
+  // X during cycle c
+  int x_at(uint64_t c) const;
+};
+
+trace::trace() {
+  reader in;
+  uint64_t cycle = 1;
+  int x = 1;
+  int c;
+  while ((c = in.get()) != EOF) {
+    if (c == '\n')
+      continue;
+    if (c == 'n') {
+      // noop just delays
+      in.skip_line();
+      cycle += 1;
+      continue;
+    }
+    assert(c == 'a');
+    // Skip the rest of "addx"
+    for (int i = 0; i < 3; ++i)
+      in.get();
+    long delta = in.read_int();
+    // addx takes two cycles before changing X
+    cycle += 2;
+    if (delta != 0) {
+      x += delta;
+      starts.push_back(cycle);
+      xs.push_back(x);
+    }
+  }
+  num_cycles = cycle - 1;
+}
+
+int trace::x_at(uint64_t c) const {
+  assert(c >= 1);
+  auto next = upper_bound(starts.begin(), starts.end(), c);
+  return xs[next - starts.begin() - 1];
+}
+
+void part1() {
+  trace tr;
+  long ans = 0;
+  for (int i = 20; i <= 220; i += 40)
+    ans += i * tr.x_at(i);
+  cout << ans << '\n';
+}
+
+void part2() {
+  trace tr;
+  int const width = 40;
+  size_t k = 0;
+  string row;
+  for (uint64_t row_start = 1; row_start + width - 1 <= tr.num_cycles;
+       row_start += width) {
+    uint64_t row_end = row_start + width;
+    row.assign(width, ' ');
+    // Skip spans that ended before this row
+    while (k + 1 < tr.starts.size() && tr.starts[k + 1] <= row_start)
+      ++k;
+    // The sprite covers columns x-1..x+1, so light that much of
+    // whatever part of the row each span covers
+    for (size_t j = k; j < tr.starts.size() && tr.starts[j] < row_end; ++j) {
+      uint64_t span_end =
+        j + 1 < tr.starts.size() ? min(tr.starts[j + 1], row_end) : row_end;
+      long first_col = long(max(tr.starts[j], row_start) - row_start);
+      long last_col = long(span_end - row_start) - 1;
+      long x = tr.xs[j];
+      first_col = max(first_col, x - 1);
+      last_col = min(last_col, x + 1);
+      for (long col = first_col; col <= last_col; ++col)
+        row[col] = '@';
+    }
+    cout << row << '\n';
+  }
+}
+
+void query(int num_cycles, char **cycles) {
+  trace tr;
+  for (int i = 0; i < num_cycles; ++i) {
+    uint64_t c = strtoull(cycles[i], nullptr, 10);
+    assert(1 <= c && c <= tr.num_cycles);
+    cout << c << ": " << tr.x_at(c) << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || (argc > 2 && *argv[1] != 'q')) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " q cycle... < input\n";
+    exit(1);
+  }
+  if (*argv[1] == 'q')
+    query(argc - 2, argv + 2);
+  else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -0,0 +1,221 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -O2 -o doit3 doit3.cc
+// ./doit3 1 < input  # part 1
+// ./doit3 2 < input  # part 2
+// ./doit3 bench [instructions]  # cycles per second on a random program
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+
+// A small emulator for the handheld's CPU.  The program is decoded
+// once into an array of (opcode, operand), and then run by a
+// threaded-code interpreter: each instruction's handler looks up the
+// next opcode's handler and jumps straight to it, rather than going
+// back around a central switch.  The per-cycle work is done by
+// observers that are template parameters, so they get inlined into
+// the handlers.
+//
+// Each instruction is a line in INSTRUCTIONS giving its name, the
+// number of cycles it takes, the number of operands, and the new
+// value of X in terms of x and the operand a.  Decoding, the opcode
+// table, and the interpreter's handlers are all generated from that,
+// so adding an instruction is just adding a line.
+#define INSTRUCTIONS(X)   \
+  X(noop, 1, 0, x)        \
+  X(addx, 2, 1, x + a)
+
+enum opcode : uint8_t {
+#define OPCODE(name, cycles, num_operands, effect) op_##name,
+  INSTRUCTIONS(OPCODE)
+#undef OPCODE
+  num_opcodes
+};
+
+struct op_info {
+  char const *name;
+  int cycles;
+  int num_operands;
+};
+
+op_info const ops[num_opcodes] = {
+#define INFO(name, cycles, num_operands, effect) \
+  { #name, cycles, num_operands },
+  INSTRUCTIONS(INFO)
+#undef INFO
+};
+
+struct instruction {
+  opcode op;
+  int operand;
+};
+
+vector<instruction> decode() {
+  vector<instruction> program;
+  string name;
+  while (cin >> name) {
+    int op = 0;
+    while (op < num_opcodes && name != ops[op].name)
+      ++op;
+    assert(op < num_opcodes);
+    instruction instr{ opcode(op), 0 };
+    if (ops[op].num_operands > 0) {
+      cin >> instr.operand;
+      assert(cin);
+    }
+    program.push_back(instr);
+  }
+  return program;
+}
+
+// Observers get tick(cycle, x) for every cycle, numbered from 1
+template <typename... Observers>
+struct observers : Observers... {
+  void tick(uint64_t t, int x) { (Observers::tick(t, x), ...); }
+};
+
+template <typename Observer>
+void run(vector<instruction> const &program, Observer &observer) {
+  uint64_t t = 0;
+  int x = 1;
+#ifdef __GNUC__
+  // Labels as values, a GCC/Clang extension
+  static void *const handlers[num_opcodes] = {
+#define HANDLER_ADDRESS(name, cycles, num_operands, effect) &&do_##name,
+    INSTRUCTIONS(HANDLER_ADDRESS)
+#undef HANDLER_ADDRESS
+  };
+  instruction const *pc = program.data();
+  instruction const *end = pc + program.size();
+  // Each handler does its own dispatch to the next one, which gives the
+  // branch predictor a separate history for each
+#define DISPATCH                       \
+  if (pc == end)                       \
+    return;                            \
+  goto *handlers[pc->op]
+  DISPATCH;
+#define HANDLER(name, cycles, num_operands, effect) \
+  do_##name: {                                      \
+    int a = pc->operand;                            \
+    (void)a;                                        \
+    for (int i = 0; i < cycles; ++i)                \
+      observer.tick(++t, x);                        \
+    x = (effect);                                   \
+    ++pc;                                           \
+    DISPATCH;                                       \
+  }
+  INSTRUCTIONS(HANDLER)
+#undef HANDLER
+#undef DISPATCH
+#else
+  // Portable fallback
+  for (auto const &instr : program) {
+    int a = instr.operand;
+    (void)a;
+    switch (instr.op) {
+#define CASE(name, cycles, num_operands, effect) \
+    case op_##name:                              \
+      for (int i = 0; i < cycles; ++i)           \
+        observer.tick(++t, x);                   \
+      x = (effect);                              \
+      break;
+      INSTRUCTIONS(CASE)
+#undef CASE
+    default:
+      assert(false);
+    }
+  }
+#endif
+}
+
+// Signal strength at cycles 20, 60, ..., 220.  This runs every cycle,
+// so it compares against the next cycle of interest instead of
+// dividing.
+struct signal_probe {
+  long strength{0};
+  uint64_t next{20};
+  void tick(uint64_t t, int x) {
+    if (t == next) {
+      strength += long(t) * x;
+      next = t < 220 ? t + 40 : 0;
+    }
+  }
+};
+
+// The CRT beam draws a row of 40 pixels at a time
+struct crt_beam {
+  int c{0};
+  void tick(uint64_t, int x) {
+    cout << ((c >= x - 1 && c <= x + 1) ? '@' : ' ');
+    if (++c == 40) {
+      cout << '\n';
+      c = 0;
+    }
+  }
+};
+
+// Something to keep the benchmark from being optimized away
+struct checksum {
+  uint64_t sum{0};
+  void tick(uint64_t t, int x) { sum += t ^ x; }
+};
+
+void part1() {
+  auto program = decode();
+  observers<signal_probe> probe;
+  run(program, probe);
+  cout << probe.strength << '\n';
+}
+
+void part2() {
+  auto program = decode();
+  observers<crt_beam> crt;
+  run(program, crt);
+}
+
+void bench(size_t num_instructions) {
+  vector<instruction> program;
+  uint64_t state = 88172645463325252ull;
+  for (size_t i = 0; i < num_instructions; ++i) {
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    if (state % 3 == 0)
+      program.push_back({ op_noop, 0 });
+    else
+      program.push_back({ op_addx, int(state >> 40) % 21 - 10 });
+  }
+  observers<signal_probe, checksum> obs;
+  auto start = chrono::steady_clock::now();
+  run(program, obs);
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  uint64_t num_cycles = 0;
+  for (auto const &instr : program)
+    num_cycles += ops[instr.op].cycles;
+  cout << num_cycles << " cycles in " << elapsed.count() << "s, "
+       << num_cycles / elapsed.count() / 1e6 << "M cycles/s (checksum "
+       << obs.sum << ")\n";
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || (argc > 2 && strcmp(argv[1], "bench") != 0)) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " bench [instructions]\n";
+    exit(1);
+  }
+  if (strcmp(argv[1], "bench") == 0)
+    bench(argc > 2 ? atol(argv[2]) : 100000000);
+  else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
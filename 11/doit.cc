@@ -5,12 +5,12 @@
 
 #include <iostream>
 #include <string>
-#include <list>
 #include <vector>
-#include <functional>
+#include <array>
 #include <numeric>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cassert>
 
 using namespace std;
@@ -36,8 +36,8 @@ void expect(string const &word) {
 
 // Get some numbers, list continues as long as there are comma
 // separators
-list<num> numbers() {
-  list<num> ns;
+vector<num> numbers() {
+  vector<num> ns;
   bool num_expected = true;
   do {
     auto t = token();
@@ -54,107 +54,164 @@ num number() {
   return ns.front();
 }
 
-// One of the little devils
-struct monkey {
-  // What the monkey currently has
-  list<num> holding;
-  // How it updates the worry level
-  function<num(num)> update;
+// How a monkey updates the worry level
+enum operation : uint8_t { add, multiply, square };
+
+// Lemire's fast divisibility test: with m = ceil(2^64 / d), n is
+// divisible by d iff n * m (mod 2^64) < m, for 32-bit n and d.  For
+// d = 1, m is 2^64, which wraps to 0, so this keeps m - 1 instead
+// and tests n * m <= m - 1, which then holds for every n as it should.
+struct divisibility {
+  uint64_t m_minus_1;
+  divisibility(uint32_t d = 1) : m_minus_1(~uint64_t(0) / d) {}
+  bool divides(uint32_t n) const {
+    return n * (m_minus_1 + 1) <= m_minus_1;
+  }
+};
+
+// All the little devils, stored as structure-of-arrays.  The items
+// are in a power-of-two ring buffer per monkey, which starts out big
+// enough for the monkey's starting items and doubles if it ever
+// fills, so after the first few rounds nothing more gets allocated.
+struct monkeys {
+  size_t n{0};
+  // How each monkey updates the worry level
+  vector<operation> op;
+  vector<num> operand;
   // What the monkey checks for divibility by
-  unsigned divisor;
+  vector<unsigned> divisor;
+  vector<divisibility> test;
   // Which monkeys it throws to
-  unsigned recipient[2];
+  vector<array<unsigned, 2>> recipient;
   // How many items the monkey has handled
-  unsigned num_handled{0};
+  vector<size_t> num_handled;
+  // LCM of divisors of all monkeys, for reducing
+  num lcm_divisors{1};
+
+  // Ring buffers: monkey i's holds count[i] items starting at head[i]
+  vector<vector<num>> items;
+  vector<size_t> head;
+  vector<size_t> count;
 
-  // Read and construct from stdin
-  monkey();
+  // Read all monkeys from stdin
+  monkeys();
 
   // Catch an item thrown by another monkey
-  void receive(num worry_level) { holding.push_back(worry_level); }
+  void receive(unsigned i, num worry_level) {
+    if (count[i] == items[i].size())
+      grow(i);
+    items[i][(head[i] + count[i]++) & (items[i].size() - 1)] = worry_level;
+  }
 
-  // Do one turn, throwing items to other monkeys
-  void turn(vector<monkey> &monkeys, unsigned relief);
+  // Double the size of monkey i's ring buffer
+  void grow(unsigned i);
 
-  // LCM of divisors of all monkeys, for reducing
-  static num lcm_divisors;
+  // Do one turn for monkey i, throwing items to other monkeys
+  void turn(unsigned i, unsigned relief);
 };
 
-num monkey::lcm_divisors = 1;
-
 // For conciseness...
 #define e(word) expect(word)
 
-monkey::monkey() {
-  e("Monkey"); (void)number();          // colon was eaten by number()
-  e("Starting"); e("items:"); holding = numbers();
-  e("Operation:"); e("new"); e("="); e("old");
-  auto op = token();
-  if (op == "+") {
-    num v = number();
-    update = [=](num n) { return n + v; };
-  } else {
-    assert(op == "*");
-    // Could be multiplying by a number or squaring
+monkeys::monkeys() {
+  auto another_monkey = []() {
+                          while (cin && isspace(cin.peek()))
+                            cin.ignore(1);
+                          return !cin.eof();
+                        };
+  vector<vector<num>> starting;
+  while (another_monkey()) {
+    e("Monkey"); (void)number();        // colon was eaten by number()
+    e("Starting"); e("items:"); starting.push_back(numbers());
+    e("Operation:"); e("new"); e("="); e("old");
     auto t = token();
-    if (t == "old")
-      update = [](num n) { return n * n; };
-    else {
-      num v = stoul(t);
-      update = [=](num n) { return n * v; };
+    if (t == "+") {
+      op.push_back(add);
+      operand.push_back(number());
+    } else {
+      assert(t == "*");
+      // Could be multiplying by a number or squaring
+      t = token();
+      if (t == "old") {
+        op.push_back(square);
+        operand.push_back(0);
+      } else {
+        op.push_back(multiply);
+        operand.push_back(stoul(t));
+      }
     }
+    e("Test:"); e("divisible"); e("by");
+    divisor.push_back(number());
+    test.emplace_back(divisor.back());
+    lcm_divisors = lcm(lcm_divisors, num(divisor.back()));
+    e("If"); e("true:"); e("throw"); e("to"); e("monkey");
+    unsigned if_true = number();
+    e("If"); e("false:"); e("throw"); e("to"); e("monkey");
+    unsigned if_false = number();
+    recipient.push_back({ if_true, if_false });
+  }
+  n = op.size();
+  // The reduced worry levels have to fit for the fast divisibility
+  // test, and squaring them has to fit in a num
+  assert(lcm_divisors <= UINT32_MAX);
+  num_handled.assign(n, 0);
+  items.resize(n);
+  head.assign(n, 0);
+  count.assign(n, 0);
+  for (unsigned i = 0; i < n; ++i) {
+    size_t capacity = 16;
+    while (capacity < starting[i].size())
+      capacity *= 2;
+    items[i].resize(capacity);
+    for (auto worry_level : starting[i])
+      receive(i, worry_level);
   }
-  e("Test:"); e("divisible"); e("by");
-  divisor = number();
-  lcm_divisors = lcm(lcm_divisors, divisor);
-  e("If"); e("true:"); e("throw"); e("to"); e("monkey");
-  recipient[0] = number();
-  e("If"); e("false:"); e("throw"); e("to"); e("monkey");
-  recipient[1] = number();
 }
 
 #undef e
 
-void monkey::turn(vector<monkey> &monkeys, unsigned relief) {
-  while (!holding.empty()) {
+void monkeys::grow(unsigned i) {
+  // Unwrap into a buffer twice the size
+  vector<num> bigger(2 * items[i].size());
+  for (size_t k = 0; k < count[i]; ++k)
+    bigger[k] = items[i][(head[i] + k) & (items[i].size() - 1)];
+  items[i].swap(bigger);
+  head[i] = 0;
+}
+
+void monkeys::turn(unsigned i, unsigned relief) {
+  // Items are never thrown to the monkey doing the throwing, so its
+  // ring doesn't change size during the turn
+  num const *ring = items[i].data();
+  size_t mask = items[i].size() - 1;
+  num_handled[i] += count[i];
+  for (; count[i] > 0; --count[i]) {
     // Monkey takes an item
-    num worry_level = holding.front();
-    holding.pop_front();
-    ++num_handled;
+    num worry_level = ring[head[i]];
+    head[i] = (head[i] + 1) & mask;
     // Worry level update during inspection
-    worry_level = update(worry_level);
+    switch (op[i]) {
+    case add: worry_level += operand[i]; break;
+    case multiply: worry_level *= operand[i]; break;
+    case square: worry_level *= worry_level; break;
+    }
     // Relief that item was not damaged
     worry_level /= relief;
     // Reduce, preserving divisibility for all monkeys
     worry_level %= lcm_divisors;
     // Throw to the next monkey
-    unsigned throw_to = recipient[worry_level % divisor != 0];
-    assert(throw_to < monkeys.size());
-    monkeys[throw_to].receive(worry_level);
+    unsigned throw_to = recipient[i][!test[i].divides(worry_level)];
+    assert(throw_to < n && throw_to != i);
+    receive(throw_to, worry_level);
   }
 }
 
-// Read all monkeys
-vector<monkey> read() {
-  auto another_monkey = []() {
-                          while (cin && isspace(cin.peek()))
-                            cin.ignore(1);
-                          return !cin.eof();
-                        };
-  vector<monkey> monkeys;
-  while (another_monkey())
-    monkeys.emplace_back();
-  return monkeys;
-}
-
 void monkey_business(unsigned num_rounds, unsigned relief) {
-  auto monkeys = read();
+  monkeys ms;
   for (unsigned _ = 0; _ < num_rounds; ++_)
-    for (auto &m : monkeys)
-      m.turn(monkeys, relief);
-  vector<size_t> activity;
-  for (auto const &m : monkeys)
-    activity.push_back(m.num_handled);
+    for (unsigned i = 0; i < ms.n; ++i)
+      ms.turn(i, relief);
+  vector<size_t> activity(ms.num_handled);
   sort(activity.begin(), activity.end(), greater());
   assert(activity.size() >= 2);
   cout << activity[0] * activity[1] << '\n';
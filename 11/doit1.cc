@@ -0,0 +1,271 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -pthread -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+// ./doit1 2 1000000000000 < input  # part 2 with any number of rounds
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <cassert>
+
+using namespace std;
+
+// Items never interact, so each one can be followed on its own.  At
+// the start of a round an item is described by which monkey has it
+// and its worry level (reduced mod the LCM of the divisors as in
+// doit.cc).  During the round it gets passed along to higher-numbered
+// monkeys, who deal with it in the same round, until it goes to a
+// monkey that's already had its turn.  That gives the state for the
+// start of the next round.  There are only finitely many states, so
+// eventually the item's trajectory repeats, and from then on the
+// handled counts just add up cycle by cycle.  The cost per item is
+// the length of the lead-in plus one cycle, regardless of the number
+// of rounds.
+//
+// Since only the handled counts are shared, the items are also split
+// up among threads, each keeping its own counts that get added up at
+// the end.
+
+using num = unsigned long;
+
+// Get the next input token
+string token() {
+  string token;
+  cin >> token;
+  assert(cin);
+  return token;
+}
+
+// Consume some expected word
+void expect(string const &word) {
+  auto t = token();
+  assert(t == word);
+}
+
+// Get some numbers, list continues as long as there are comma
+// separators
+vector<num> numbers() {
+  vector<num> ns;
+  bool num_expected = true;
+  do {
+    auto t = token();
+    ns.emplace_back(stoul(t));
+    num_expected = t.back() == ',';
+  } while (num_expected);
+  return ns;
+}
+
+// Get exactly one number
+num number() {
+  auto ns = numbers();
+  assert(ns.size() == 1);
+  return ns.front();
+}
+
+struct monkey {
+  // Starting items
+  vector<num> holding;
+  // How it updates the worry level
+  function<num(num)> update;
+  // What the monkey checks for divibility by
+  unsigned divisor;
+  // Which monkeys it throws to
+  unsigned recipient[2];
+
+  // Read and construct from stdin
+  monkey();
+
+  // Where an item with the given worry level goes (and its new
+  // worry level)
+  unsigned inspect(num &worry_level, unsigned relief, num lcm) const {
+    worry_level = update(worry_level) / relief % lcm;
+    return recipient[worry_level % divisor != 0];
+  }
+};
+
+// For conciseness...
+#define e(word) expect(word)
+
+monkey::monkey() {
+  e("Monkey"); (void)number();          // colon was eaten by number()
+  e("Starting"); e("items:"); holding = numbers();
+  e("Operation:"); e("new"); e("="); e("old");
+  auto op = token();
+  if (op == "+") {
+    num v = number();
+    update = [=](num n) { return n + v; };
+  } else {
+    assert(op == "*");
+    // Could be multiplying by a number or squaring
+    auto t = token();
+    if (t == "old")
+      update = [](num n) { return n * n; };
+    else {
+      num v = stoul(t);
+      update = [=](num n) { return n * v; };
+    }
+  }
+  e("Test:"); e("divisible"); e("by");
+  divisor = number();
+  e("If"); e("true:"); e("throw"); e("to"); e("monkey");
+  recipient[0] = number();
+  e("If"); e("false:"); e("throw"); e("to"); e("monkey");
+  recipient[1] = number();
+}
+
+#undef e
+
+// Read all monkeys
+vector<monkey> read() {
+  auto another_monkey = []() {
+                          while (cin && isspace(cin.peek()))
+                            cin.ignore(1);
+                          return !cin.eof();
+                        };
+  vector<monkey> monkeys;
+  while (another_monkey())
+    monkeys.emplace_back();
+  return monkeys;
+}
+
+// Follows items for one thread, keeping the scratch space for cycle
+// detection around between items
+struct item_follower {
+  vector<monkey> const &monkeys;
+  uint64_t num_rounds;
+  unsigned relief;
+  num lcm;
+  // This thread's handled counts
+  vector<uint64_t> num_handled;
+  // Round in which each state was first seen at the start
+  unordered_map<num, uint64_t> seen;
+  // The set of monkeys that handled the item in each round.  Monkeys
+  // handle it in increasing order within a round, so no monkey
+  // appears twice.
+  vector<uint64_t> handlers;
+
+  item_follower(vector<monkey> const &monkeys_, uint64_t num_rounds_,
+                unsigned relief_, num lcm_) :
+    monkeys(monkeys_), num_rounds(num_rounds_), relief(relief_), lcm(lcm_),
+    num_handled(monkeys_.size(), 0) {}
+
+  // Add up the handlers for rounds [begin, end), times repeat
+  void tally(uint64_t begin, uint64_t end, uint64_t repeat);
+
+  // Add the handling of copies of an item over all the rounds
+  void follow(unsigned m, num worry_level, uint64_t copies);
+};
+
+void item_follower::tally(uint64_t begin, uint64_t end, uint64_t repeat) {
+  for (uint64_t r = begin; r < end; ++r)
+    for (uint64_t bits = handlers[r]; bits; bits &= bits - 1)
+      num_handled[__builtin_ctzll(bits)] += repeat;
+}
+
+void item_follower::follow(unsigned m, num worry_level, uint64_t copies) {
+  size_t n = monkeys.size();
+  seen.clear();
+  handlers.clear();
+  for (uint64_t round = 0; round < num_rounds; ++round) {
+    auto [prev, inserted] = seen.emplace(worry_level * n + m, round);
+    if (!inserted) {
+      // Cycle found; rounds [start, round) repeat from here on
+      uint64_t start = prev->second;
+      uint64_t cycle = round - start;
+      uint64_t remaining = num_rounds - round;
+      tally(0, round, copies);
+      tally(start, start + cycle, remaining / cycle * copies);
+      tally(start, start + remaining % cycle, copies);
+      return;
+    }
+    uint64_t handled = 0;
+    unsigned next;
+    for (;;) {
+      handled |= uint64_t(1) << m;
+      next = monkeys[m].inspect(worry_level, relief, lcm);
+      assert(next < n);
+      if (next <= m)
+        break;
+      m = next;
+    }
+    m = next;
+    handlers.push_back(handled);
+  }
+  // No cycle within the rounds asked for
+  tally(0, num_rounds, copies);
+}
+
+void monkey_business(uint64_t num_rounds, unsigned relief) {
+  auto monkeys = read();
+  assert(monkeys.size() <= 64);
+  num lcm_divisors = 1;
+  for (auto const &m : monkeys)
+    lcm_divisors = lcm(lcm_divisors, num(m.divisor));
+  // All the items as (monkey, worry level).  Items that start out the
+  // same go the same way, so they're only followed once.
+  vector<pair<unsigned, num>> all_items;
+  for (unsigned m = 0; m < monkeys.size(); ++m)
+    for (auto worry_level : monkeys[m].holding)
+      all_items.emplace_back(m, worry_level);
+  sort(all_items.begin(), all_items.end());
+  vector<pair<pair<unsigned, num>, uint64_t>> items;
+  for (auto const &item : all_items)
+    if (!items.empty() && items.back().first == item)
+      ++items.back().second;
+    else
+      items.push_back({ item, 1 });
+  // Give each thread an equal share of the items
+  size_t num_threads = max(1u, thread::hardware_concurrency());
+  vector<item_follower> followers;
+  for (size_t t = 0; t < num_threads; ++t)
+    followers.emplace_back(monkeys, num_rounds, relief, lcm_divisors);
+  vector<thread> threads;
+  for (size_t t = 0; t < num_threads; ++t)
+    threads.emplace_back([&, t]() {
+                           size_t begin = items.size() * t / num_threads;
+                           size_t end = items.size() * (t + 1) / num_threads;
+                           for (size_t i = begin; i < end; ++i)
+                             followers[t].follow(items[i].first.first,
+                                                 items[i].first.second,
+                                                 items[i].second);
+                         });
+  for (auto &th : threads)
+    th.join();
+  vector<uint64_t> activity(monkeys.size(), 0);
+  for (auto const &f : followers)
+    for (size_t i = 0; i < monkeys.size(); ++i)
+      activity[i] += f.num_handled[i];
+  sort(activity.begin(), activity.end(), greater());
+  assert(activity.size() >= 2);
+  // With enough rounds the product won't fit in 64 bits
+  unsigned __int128 ans = (unsigned __int128)activity[0] * activity[1];
+  string digits;
+  do {
+    digits.push_back('0' + int(ans % 10));
+    ans /= 10;
+  } while (ans > 0);
+  reverse(digits.begin(), digits.end());
+  cout << digits << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2 && argc != 3) {
+    cerr << "usage: " << argv[0] << " partnum [rounds] < input\n";
+    exit(1);
+  }
+  bool part1 = *argv[1] == '1';
+  uint64_t num_rounds = part1 ? 20 : 10000;
+  if (argc == 3)
+    num_rounds = strtoull(argv[2], nullptr, 10);
+  monkey_business(num_rounds, part1 ? 3 : 1);
+  return 0;
+}
@@ -6,40 +6,38 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <list>
-#include <set>
-#include <functional>
 #include <utility>
+#include <cstdint>
 #include <cassert>
 
 using namespace std;
 
-using pos = pair<int, int>;
+// Cells are numbered row-major in a grid with a one-cell border all
+// around, so the neighbors of cell p are just p-1, p+1, p-pw and p+pw, and
+// there's never any need to check whether a step stays on the map.
+using cell = uint32_t;
 
 struct height_map {
-  vector<string> heights;
-  pos start_end[2];
+  // Size without the border
+  int w{0};
+  int h{0};
+  // Padded width
+  int pw{0};
+  // Row-major heights including the border
+  vector<unsigned char> heights;
+  cell start_end[2];
+
+  // Height of the border, too big to ever be reached by legal steps
+  static constexpr unsigned char wall = 'z' + 2;
 
   height_map();
 
-  int w() const { return heights[0].length(); }
-  int h() const { return heights.size(); }
+  size_t size() const { return heights.size(); }
 
-  pos start() const { return start_end[0]; }
-  pos end() const { return start_end[1]; }
+  cell start() const { return start_end[0]; }
+  cell end() const { return start_end[1]; }
 
-  bool valid(pos const &p) const {
-    return p.first >= 0 && p.first < h() && p.second >= 0 && p.second < w();
-  }
-
-  // Height for valid positions, otherwise a height that's too big to
-  // ever be reached by legal steps
-  char at(pos const &p) const {
-    return valid(p) ? heights[p.first][p.second] : 'z' + 2;
-  }
-
-  // All new positions that can be visited from p
-  list<pos> steps_from(pos const &p, set<pos> const &visited) const;
+  unsigned char at(cell p) const { return heights[p]; }
 
   // Remap for part 2
   void flip();
@@ -48,34 +46,30 @@ struct height_map {
 height_map::height_map() {
   string line;
   while (getline(cin, line)) {
+    if (h == 0) {
+      w = line.length();
+      pw = w + 2;
+      heights.assign(pw, wall);
+    }
+    assert(int(line.length()) == w);
     char special[2] = { 'S', 'E' };
     for (int i = 0; i < 2; ++i) {
       auto pos = line.find(special[i]);
       if (pos != string::npos) {
-        start_end[i] = make_pair(heights.size(), pos);
+        start_end[i] = heights.size() + 1 + pos;
         line[pos] = i ? 'z' : 'a';
       }
     }
-    heights.push_back(line);
-    assert(int(line.length()) == w());
+    heights.push_back(wall);
+    heights.insert(heights.end(), line.begin(), line.end());
+    heights.push_back(wall);
+    ++h;
   }
+  heights.insert(heights.end(), pw, wall);
+  assert(size() < UINT32_MAX);
   assert(at(start()) == 'a' && at(end()) == 'z');
 }
 
-list<pos> height_map::steps_from(pos const &p, set<pos> const &visited) const {
-  list<pos> result;
-  auto consider =
-    [&](pos const &p1) {
-      if (visited.find(p1) == visited.end() && at(p1) <= at(p) + 1)
-        result.push_back(p1);
-    };
-  consider(make_pair(p.first + 1, p.second));
-  consider(make_pair(p.first - 1, p.second));
-  consider(make_pair(p.first, p.second + 1));
-  consider(make_pair(p.first, p.second - 1));
-  return result;
-}
-
 void height_map::flip() {
   // Searching from the starting z to some a, descending at most 1
   // each step is equivalent to flipping the heights and searching
@@ -83,38 +77,92 @@ void height_map::flip() {
   // step.  Hence part 2 is just part 1 but with flipped heights (and
   // a slightly different ending condition).
   swap(start_end[0], start_end[1]);
-  for (auto &row : heights)
-    for (auto &h : row)
+  for (auto &h : heights)
+    if (h != wall)
       h = 'a' + ('z' - h);
 }
 
-void bfs(height_map const &map, function<bool(pos const &)> done) {
-  list<pair<pos, int>> frontier;
-  set<pos> visited;
-  auto visit = [&](pos const &p, int num_steps) {
-                 frontier.emplace_back(p, num_steps);
-                 visited.emplace(p);
+// FIFO of cells in a power-of-two ring buffer.  The queue only ever
+// holds the tail of one BFS layer and the start of the next, which is
+// usually much smaller than the map, so it starts out a few rows long
+// and doubles if it ever fills.
+struct cell_queue {
+  vector<cell> ring;
+  size_t head{0};
+  size_t count{0};
+
+  cell_queue(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity)
+      n *= 2;
+    ring.resize(n);
+  }
+
+  bool empty() const { return count == 0; }
+
+  void push(cell p) {
+    if (count == ring.size())
+      grow();
+    ring[(head + count++) & (ring.size() - 1)] = p;
+  }
+
+  cell pop() {
+    cell p = ring[head];
+    head = (head + 1) & (ring.size() - 1);
+    --count;
+    return p;
+  }
+
+  void grow() {
+    // Unwrap into a buffer twice the size
+    vector<cell> bigger(2 * ring.size());
+    for (size_t i = 0; i < count; ++i)
+      bigger[i] = ring[(head + i) & (ring.size() - 1)];
+    ring.swap(bigger);
+    head = 0;
+  }
+};
+
+// Breadth-first search from the start until done(p) is true for some
+// cell, returns the number of steps to get there
+template <typename Done>
+uint32_t bfs(height_map const &map, Done done) {
+  // One bit per cell for visited, and the step count for each cell
+  // that's been reached
+  vector<uint64_t> visited((map.size() + 63) / 64, 0);
+  vector<uint32_t> dist(map.size());
+  cell_queue frontier(4 * size_t(map.pw));
+  auto visit = [&](cell p, uint32_t num_steps) {
+                 visited[p / 64] |= uint64_t(1) << (p % 64);
+                 dist[p] = num_steps;
+                 frontier.push(p);
                };
+  int const offsets[4] = { 1, -1, map.pw, -map.pw };
   visit(map.start(), 0);
-  while (!done(frontier.front().first)) {
-    auto [pos, num_steps] = frontier.front();
-    frontier.pop_front();
-    for (auto next : map.steps_from(pos, visited))
-      visit(next, num_steps + 1);
+  for (;;) {
     assert(!frontier.empty());
+    cell p = frontier.pop();
+    if (done(p))
+      return dist[p];
+    unsigned reachable = map.at(p) + 1;
+    for (int off : offsets) {
+      cell next = p + off;
+      if (!(visited[next / 64] & (uint64_t(1) << (next % 64))) &&
+          map.at(next) <= reachable)
+        visit(next, dist[p] + 1);
+    }
   }
-  cout << frontier.front().second << '\n';
 }
 
 void part1() {
   height_map map;
-  bfs(map, [&](pos const &p) { return p == map.end(); });
+  cout << bfs(map, [&](cell p) { return p == map.end(); }) << '\n';
 }
 
 void part2() {
   height_map map;
   map.flip();
-  bfs(map, [&](pos const &p) { return map.at(p) == 'z'; });
+  cout << bfs(map, [&](cell p) { return map.at(p) == 'z'; }) << '\n';
 }
 
 int main(int argc, char **argv) {
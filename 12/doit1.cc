@@ -0,0 +1,188 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+using namespace std;
+
+// A bit-parallel version of doit.cc's BFS.  Rather than expanding one
+// cell at a time, each BFS layer is a bitset with one row of words per
+// map row, and the whole layer is expanded at once: the frontier cells
+// of height k spread to their four neighbors by shifting, and the
+// result is masked with the plane of cells that can be stepped to
+// from height k, i.e., those no higher than k+1.  There are only 26
+// heights, so a layer costs a small constant times the number of
+// words in the frontier.
+
+using pos = pair<int, int>;
+
+struct height_map {
+  vector<string> heights;
+  pos start_end[2];
+
+  height_map();
+
+  int w() const { return heights[0].length(); }
+  int h() const { return heights.size(); }
+
+  pos start() const { return start_end[0]; }
+  pos end() const { return start_end[1]; }
+
+  char at(pos const &p) const { return heights[p.first][p.second]; }
+
+  // Remap for part 2, see doit.cc
+  void flip();
+};
+
+height_map::height_map() {
+  string line;
+  while (getline(cin, line)) {
+    char special[2] = { 'S', 'E' };
+    for (int i = 0; i < 2; ++i) {
+      auto pos = line.find(special[i]);
+      if (pos != string::npos) {
+        start_end[i] = make_pair(heights.size(), pos);
+        line[pos] = i ? 'z' : 'a';
+      }
+    }
+    heights.push_back(line);
+    assert(int(line.length()) == w());
+  }
+  assert(at(start()) == 'a' && at(end()) == 'z');
+}
+
+void height_map::flip() {
+  swap(start_end[0], start_end[1]);
+  for (auto &row : heights)
+    for (auto &h : row)
+      h = 'a' + ('z' - h);
+}
+
+int const num_heights = 26;
+
+// Bitsets over the map.  Each row is stride words, which is one more
+// than needed so that there's always a zero word between rows, and
+// there's an extra zero row above and below.  Bits shifted past the
+// edge of the map thus land in padding, where they get masked off.
+struct grid_bits {
+  int h;
+  size_t stride;
+
+  grid_bits(int w_, int h_) : h(h_), stride((w_ + 63) / 64 + 1) {}
+
+  size_t size() const { return (h + 2) * stride; }
+  // Index of the word holding (i, j), and the bit for j in it
+  size_t word(int i, int j) const { return (i + 1) * stride + j / 64; }
+  static uint64_t bit(int j) { return uint64_t(1) << (j % 64); }
+
+  vector<uint64_t> empty() const { return vector<uint64_t>(size(), 0); }
+};
+
+// Breadth-first search from the start until reaching some cell in
+// target, returns the number of steps
+int bfs(height_map const &map, grid_bits const &g,
+        vector<uint64_t> const &target) {
+  // below[k] has the cells of height at most k; cells that can be
+  // stepped to from height k are then below[k+1], and those of exactly
+  // height k are below[k] minus below[k-1]
+  vector<vector<uint64_t>> below(num_heights, g.empty());
+  for (int i = 0; i < map.h(); ++i)
+    for (int j = 0; j < map.w(); ++j)
+      below[map.at({ i, j }) - 'a'][g.word(i, j)] |= g.bit(j);
+  for (int k = 1; k < num_heights; ++k)
+    for (size_t w = 0; w < g.size(); ++w)
+      below[k][w] |= below[k - 1][w];
+  // The frontier and the next layer are kept both as bitsets and as
+  // lists of their nonzero words, so that a thin frontier in a big
+  // map only costs as much as its own words
+  auto frontier = g.empty();
+  auto next = g.empty();
+  auto visited = g.empty();
+  vector<size_t> frontier_words;
+  vector<size_t> next_words;
+  auto reach = [&](size_t w, uint64_t bits) {
+                 if (bits && !next[w])
+                   next_words.push_back(w);
+                 next[w] |= bits;
+               };
+  auto [si, sj] = map.start();
+  size_t sw = g.word(si, sj);
+  frontier[sw] = visited[sw] = g.bit(sj);
+  frontier_words.push_back(sw);
+  for (int num_steps = 0; ; ++num_steps) {
+    assert(!frontier_words.empty());
+    for (auto w : frontier_words)
+      if (frontier[w] & target[w])
+        return num_steps;
+    for (auto w : frontier_words) {
+      uint64_t f = frontier[w];
+      for (int k = 0; f; ++k) {
+        uint64_t s = f & below[k][w];
+        if (!s)
+          continue;
+        f &= ~s;
+        auto const &to = below[min(k + 1, num_heights - 1)];
+        reach(w - g.stride, s & to[w - g.stride]);
+        reach(w + g.stride, s & to[w + g.stride]);
+        reach(w, ((s << 1) | (s >> 1)) & to[w]);
+        reach(w + 1, (s >> 63) & to[w + 1]);
+        reach(w - 1, (s << 63) & to[w - 1]);
+      }
+    }
+    // The new layer is what's been reached for the first time
+    for (auto w : frontier_words)
+      frontier[w] = 0;
+    frontier_words.clear();
+    for (auto w : next_words) {
+      uint64_t bits = next[w] & ~visited[w];
+      next[w] = 0;
+      if (bits) {
+        visited[w] |= bits;
+        frontier[w] = bits;
+        frontier_words.push_back(w);
+      }
+    }
+    next_words.clear();
+  }
+}
+
+void part1() {
+  height_map map;
+  grid_bits g(map.w(), map.h());
+  auto target = g.empty();
+  auto [ei, ej] = map.end();
+  target[g.word(ei, ej)] = g.bit(ej);
+  cout << bfs(map, g, target) << '\n';
+}
+
+void part2() {
+  height_map map;
+  map.flip();
+  grid_bits g(map.w(), map.h());
+  auto target = g.empty();
+  for (int i = 0; i < map.h(); ++i)
+    for (int j = 0; j < map.w(); ++j)
+      if (map.at({ i, j }) == 'z')
+        target[g.word(i, j)] |= g.bit(j);
+  cout << bfs(map, g, target) << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
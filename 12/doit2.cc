@@ -0,0 +1,231 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit2 doit2.cc
+// ./doit2 1 < input  # part 1
+// ./doit2 2 < input  # part 2
+// ./doit2 save < input > field  # precompute the distance field
+// ./doit2 q query... < input  # or < field; query is row,col or a height
+//
+// Anything that reads input also accepts a saved field instead
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+
+// Every question in the puzzle is "how many steps from here to the
+// end?", so this does one BFS backward from the end over the whole
+// map and keeps the resulting distance for every cell.  Steps from any
+// cell is then a lookup, and so is the closest cell of each height,
+// which is worked out once from the field.  Part 1 is the distance
+// from S and part 2 the distance from the closest a.
+//
+// The field can be written out and read back in, so a big map only
+// needs the BFS once no matter how many queries are run against it.
+// Saved fields are in the machine's byte order.
+
+// Saved fields start with this, which can't start a map
+string const magic = "# day 12 distance field\n";
+
+struct distance_field {
+  int w{0};
+  int h{0};
+  // Row-major heights, with S and E replaced by a and z
+  string heights;
+  size_t start{0};
+  size_t end{0};
+  // Steps from each cell to the end
+  vector<uint32_t> dist;
+  // For each height, the cell of that height that's closest to the end
+  vector<size_t> nearest;
+
+  static constexpr uint32_t unreachable = UINT32_MAX;
+  static constexpr size_t none = SIZE_MAX;
+
+  // Parse a map and search it, or load a saved field
+  distance_field(istream &in);
+
+  void save(ostream &out) const;
+
+  uint32_t steps_from(int i, int j) const {
+    assert(i >= 0 && i < h && j >= 0 && j < w);
+    return dist[size_t(i) * w + j];
+  }
+
+private:
+  void read_map(istream &in);
+  void bfs();
+  void load(istream &in);
+  void index();
+};
+
+distance_field::distance_field(istream &in) {
+  if (in.peek() == magic[0])
+    load(in);
+  else {
+    read_map(in);
+    bfs();
+  }
+  index();
+}
+
+void distance_field::read_map(istream &in) {
+  string line;
+  bool found[2] = { false, false };
+  while (getline(in, line)) {
+    if (h == 0)
+      w = line.length();
+    assert(int(line.length()) == w);
+    char special[2] = { 'S', 'E' };
+    for (int i = 0; i < 2; ++i) {
+      auto pos = line.find(special[i]);
+      if (pos != string::npos) {
+        (i ? end : start) = heights.length() + pos;
+        found[i] = true;
+        line[pos] = i ? 'z' : 'a';
+      }
+    }
+    heights += line;
+    ++h;
+  }
+  assert(found[0] && found[1]);
+}
+
+void distance_field::bfs() {
+  // Going backward, a step from p to q is allowed if q is at most one
+  // lower than p.  Each cell is queued once, so the queue is just an
+  // array.
+  dist.assign(heights.length(), unreachable);
+  vector<size_t> queue(heights.length());
+  size_t head = 0;
+  size_t tail = 0;
+  dist[end] = 0;
+  queue[tail++] = end;
+  while (head < tail) {
+    size_t p = queue[head++];
+    int i = p / w;
+    int j = p % w;
+    auto consider = [&](bool valid, size_t q) {
+                      if (valid && dist[q] == unreachable &&
+                          heights[q] + 1 >= heights[p]) {
+                        dist[q] = dist[p] + 1;
+                        queue[tail++] = q;
+                      }
+                    };
+    consider(i > 0, p - w);
+    consider(i + 1 < h, p + w);
+    consider(j > 0, p - 1);
+    consider(j + 1 < w, p + 1);
+  }
+}
+
+void distance_field::save(ostream &out) const {
+  out << magic;
+  int32_t dims[2] = { w, h };
+  uint64_t ends[2] = { start, end };
+  out.write((char const *)dims, sizeof(dims));
+  out.write((char const *)ends, sizeof(ends));
+  out.write(heights.data(), heights.length());
+  out.write((char const *)dist.data(), dist.size() * sizeof(dist[0]));
+  assert(out);
+}
+
+void distance_field::load(istream &in) {
+  string header(magic.length(), '\0');
+  in.read(header.data(), header.length());
+  assert(in && header == magic);
+  int32_t dims[2];
+  uint64_t ends[2];
+  in.read((char *)dims, sizeof(dims));
+  in.read((char *)ends, sizeof(ends));
+  w = dims[0];
+  h = dims[1];
+  start = ends[0];
+  end = ends[1];
+  size_t n = size_t(w) * h;
+  heights.resize(n);
+  dist.resize(n);
+  in.read(heights.data(), n);
+  in.read((char *)dist.data(), n * sizeof(dist[0]));
+  assert(in && start < n && end < n);
+}
+
+void distance_field::index() {
+  nearest.assign(26, none);
+  for (size_t p = 0; p < dist.size(); ++p) {
+    if (dist[p] == unreachable)
+      continue;
+    int k = heights[p] - 'a';
+    assert(k >= 0 && k < 26);
+    if (nearest[k] == none || dist[p] < dist[nearest[k]])
+      nearest[k] = p;
+  }
+}
+
+void part1() {
+  distance_field field(cin);
+  assert(field.dist[field.start] != distance_field::unreachable);
+  cout << field.dist[field.start] << '\n';
+}
+
+void part2() {
+  distance_field field(cin);
+  assert(field.nearest[0] != distance_field::none);
+  cout << field.dist[field.nearest[0]] << '\n';
+}
+
+void save() {
+  distance_field field(cin);
+  field.save(cout);
+}
+
+void query(int num_queries, char **queries) {
+  distance_field field(cin);
+  for (int n = 0; n < num_queries; ++n) {
+    char const *q = queries[n];
+    cout << q << ": ";
+    if (strchr(q, ',')) {
+      // Steps from a cell
+      int i, j;
+      int ok = sscanf(q, "%d,%d", &i, &j);
+      assert(ok == 2);
+      auto steps = field.steps_from(i, j);
+      if (steps == distance_field::unreachable)
+        cout << "unreachable\n";
+      else
+        cout << steps << '\n';
+    } else {
+      // Closest cell of a height
+      assert('a' <= q[0] && q[0] <= 'z' && q[1] == '\0');
+      size_t p = field.nearest[q[0] - 'a'];
+      if (p == distance_field::none)
+        cout << "unreachable\n";
+      else
+        cout << field.dist[p] << " from " << p / field.w << ','
+             << p % field.w << '\n';
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || (argc > 2 && *argv[1] != 'q')) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " save < input > field\n";
+    cerr << "       " << argv[0] << " q row,col|height... < input\n";
+    exit(1);
+  }
+  if (*argv[1] == 'q')
+    query(argc - 2, argv + 2);
+  else if (*argv[1] == 's')
+    save();
+  else if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
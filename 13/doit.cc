@@ -1,44 +1,55 @@
 // -*- C++ -*-
-// g++ -std=c++17 -Wall -g -o doit doit.cc
+// g++ -std=c++17 -Wall -g -pthread -o doit doit.cc
 // ./doit 1 < input  # part 1
 // ./doit 2 < input  # part 2
+// ./doit 2 divider... < input  # part 2 with other dividers
 
 #include <iostream>
 #include <vector>
 #include <string>
 #include <optional>
 #include <algorithm>
-#include <variant>
+#include <thread>
+#include <utility>
+#include <cstdint>
 #include <cstdlib>
 #include <cctype>
 #include <cassert>
 
 using namespace std;
 
-struct packet: public variant<int, vector<packet>> {
-  // Single integer
-  packet(int v) : variant(v) {}
-  // List
-  packet(vector<packet> const &pkts = vector<packet>()) : variant(pkts) {}
+// A packet is stored flat, as the sequence of tokens in its text:
+// list opens and closes plus integers (which are never negative).
+// Comparison walks two token sequences side by side, so it doesn't
+// need to build anything.
+using token = int32_t;
+token const open_list = -1;
+token const close_list = -2;
+
+struct packet {
+  vector<token> tokens;
+
+  // Parse from text
+  packet(char const *s);
 };
 
-packet read(char const *&s) {
-  if (isdigit(*s)) {
-    packet result(atoi(s));
-    while (isdigit(*s))
-      ++s;
-    return result;
-  }
-  packet result;
-  assert(*s == '[');
-  ++s;
-  while (*s != ']') {
-    get<1>(result).emplace_back(read(s));
-    if (*s == ',')
-      ++s;
+packet::packet(char const *s) {
+  while (*s) {
+    if (isdigit(*s)) {
+      tokens.push_back(atoi(s));
+      while (isdigit(*s))
+        ++s;
+      continue;
+    }
+    if (*s == '[')
+      tokens.push_back(open_list);
+    else if (*s == ']')
+      tokens.push_back(close_list);
+    else
+      assert(*s == ',');
+    ++s;
   }
-  ++s;
-  return result;
+  assert(!tokens.empty() && tokens.front() == open_list);
 }
 
 optional<packet> read_packet() {
@@ -46,24 +57,75 @@ optional<packet> read_packet() {
   while (getline(cin, line)) {
     if (line.empty())
       continue;
-    char const *s = line.c_str();
-    return read(s);
+    return packet(line.c_str());
   }
   return nullopt;
 }
 
-packet wrap(packet const &p) { return packet(vector<packet>(1, p)); }
+// Position in a packet's tokens during a comparison.  Comparing an
+// integer with a list means treating the integer as a list holding
+// just it; rather than actually doing that, the cursor notes how many
+// list levels the integer has been wrapped in, and after the integer
+// those closes are seen before the real next token.
+struct cursor {
+  token const *t;
+  // Levels wrapped around the current integer
+  int wrapped{0};
+  // Closes still to come for integers already passed
+  int pending{0};
+
+  cursor(packet const &p) : t(p.tokens.data()) {}
+
+  token peek() const { return pending > 0 ? close_list : *t; }
+
+  void advance() {
+    if (pending > 0)
+      --pending;
+    else {
+      if (*t >= 0) {
+        pending = wrapped;
+        wrapped = 0;
+      }
+      ++t;
+    }
+  }
+};
 
 int compare(packet const &l, packet const &r) {
-  if (l.index() != r.index())
-    return compare(l.index() == 0 ? wrap(l) : l,
-                   r.index() == 0 ? wrap(r) : r);
-  if (l.index() == 0)
-    return get<0>(l) - get<0>(r);
-  for (size_t i = 0; i < get<1>(l).size() && i < get<1>(r).size(); ++i)
-    if (int cmp = compare(get<1>(l)[i], get<1>(r)[i]))
-      return cmp;
-  return get<1>(l).size() - get<1>(r).size();
+  cursor lc(l);
+  cursor rc(r);
+  // Lists that both sides are in
+  int depth = 0;
+  for (;;) {
+    token a = lc.peek();
+    token b = rc.peek();
+    if (a >= 0 && b >= 0) {
+      if (a != b)
+        return a - b;
+    } else if (a == close_list || b == close_list) {
+      // Whichever list ran out first is smaller
+      if (a != b)
+        return a == close_list ? -1 : +1;
+      if (--depth == 0)
+        return 0;
+    } else if (a == open_list && b == open_list)
+      ++depth;
+    else {
+      // Integer vs. list; the integer side doesn't move but gets
+      // wrapped
+      ++depth;
+      if (a >= 0) {
+        ++lc.wrapped;
+        rc.advance();
+      } else {
+        ++rc.wrapped;
+        lc.advance();
+      }
+      continue;
+    }
+    lc.advance();
+    rc.advance();
+  }
 }
 
 bool operator<(packet const &p1, packet const &p2) {
@@ -82,28 +144,65 @@ void part1() {
   cout << ans << '\n';
 }
 
-void part2() {
+// Where the dividers would go if the packets were sorted doesn't
+// actually need any sorting: a divider's index is one more than the
+// number of packets (and other dividers) that are smaller.  With the
+// dividers sorted, a binary search among them finds which dividers
+// each packet is smaller than, and the packets are split up among
+// threads that each keep their own counts.
+void part2(vector<string> const &divider_texts) {
   vector<packet> pkts;
   while (auto p = read_packet())
     pkts.push_back(*p);
-  auto div2 = wrap(wrap(packet(2)));
-  auto div6 = wrap(wrap(packet(6)));
-  pkts.push_back(div2);
-  pkts.push_back(div6);
-  sort(pkts.begin(), pkts.end());
-  auto index2 = find(pkts.begin(), pkts.end(), div2) - pkts.begin() + 1;
-  auto index6 = find(pkts.begin(), pkts.end(), div6) - pkts.begin() + 1;
-  cout << index2 * index6 << '\n';
+  vector<packet> dividers;
+  for (auto const &text : divider_texts)
+    dividers.emplace_back(text.c_str());
+  sort(dividers.begin(), dividers.end());
+  // below[t][k] is how many packets in thread t's share are bigger
+  // than exactly k of the dividers (or equal)
+  size_t num_threads = max(1u, thread::hardware_concurrency());
+  vector<vector<size_t>> below(num_threads);
+  vector<thread> threads;
+  for (size_t t = 0; t < num_threads; ++t)
+    threads.emplace_back([&, t]() {
+                           size_t begin = pkts.size() * t / num_threads;
+                           size_t end = pkts.size() * (t + 1) / num_threads;
+                           // Count locally so that threads aren't
+                           // writing to the same cache line all the
+                           // time, and hand over the counts at the end
+                           vector<size_t> counts(dividers.size() + 1, 0);
+                           for (size_t i = begin; i < end; ++i) {
+                             auto k = upper_bound(dividers.begin(),
+                                                  dividers.end(), pkts[i]);
+                             ++counts[k - dividers.begin()];
+                           }
+                           below[t] = move(counts);
+                         });
+  for (auto &th : threads)
+    th.join();
+  // Packets smaller than divider k are the ones bigger than fewer
+  // than k+1 dividers
+  size_t smaller = 0;
+  unsigned long ans = 1;
+  for (size_t k = 0; k < dividers.size(); ++k) {
+    for (size_t t = 0; t < num_threads; ++t)
+      smaller += below[t][k];
+    ans *= smaller + k + 1;
+  }
+  cout << ans << '\n';
 }
 
 int main(int argc, char **argv) {
-  if (argc != 2) {
+  if (argc < 2 || (argc > 2 && *argv[1] != '2')) {
     cerr << "usage: " << argv[0] << " partnum < input\n";
+    cerr << "       " << argv[0] << " 2 divider... < input\n";
     exit(1);
   }
   if (*argv[1] == '1')
     part1();
+  else if (argc > 2)
+    part2(vector<string>(argv + 2, argv + argc));
   else
-    part2();
+    part2({ "[[2]]", "[[6]]" });
   return 0;
 }
@@ -0,0 +1,207 @@
+// -*- C++ -*-
+// g++ -std=c++17 -Wall -g -o doit1 doit1.cc
+// ./doit1 1 < input  # part 1
+// ./doit1 2 < input  # part 2
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cassert>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Most pairs of packets differ within the first few tokens, so there's
+// no point in parsing whole packets.  This compares straight from the
+// input text, tokenizing each side only as far as the comparison gets
+// and stopping at the first difference.  The comparison itself is the
+// same as in doit.cc, with integers that are compared against lists
+// wrapped by counting levels instead of building anything.
+//
+// The input is mapped into memory when possible, so nothing is copied
+// either.  Finding where each packet ends is still a pass over the
+// bytes, but that's just a memchr for the newline.
+
+using token = int32_t;
+token const open_list = -1;
+token const close_list = -2;
+
+// Position in a packet's text during a comparison
+struct cursor {
+  char const *s;
+  // Levels wrapped around the current integer
+  int wrapped{0};
+  // Closes still to come for integers already passed
+  int pending{0};
+  // Where the current token ends once it's been looked at
+  char const *after{nullptr};
+
+  cursor(char const *s_) : s(s_) {}
+
+  token peek();
+  void advance();
+};
+
+token cursor::peek() {
+  if (pending > 0)
+    return close_list;
+  if (*s == ',')
+    ++s;
+  after = s + 1;
+  if (*s == '[')
+    return open_list;
+  if (*s == ']')
+    return close_list;
+  assert(isdigit(*s));
+  token n = *s - '0';
+  while (isdigit(*after))
+    n = 10 * n + (*after++ - '0');
+  return n;
+}
+
+// Move past the token from the last peek()
+void cursor::advance() {
+  if (pending > 0)
+    --pending;
+  else {
+    if (isdigit(*s)) {
+      pending = wrapped;
+      wrapped = 0;
+    }
+    s = after;
+  }
+}
+
+int compare(char const *l, char const *r) {
+  cursor lc(l);
+  cursor rc(r);
+  // Lists that both sides are in
+  int depth = 0;
+  for (;;) {
+    token a = lc.peek();
+    token b = rc.peek();
+    if (a >= 0 && b >= 0) {
+      if (a != b)
+        return a - b;
+    } else if (a == close_list || b == close_list) {
+      // Whichever list ran out first is smaller
+      if (a != b)
+        return a == close_list ? -1 : +1;
+      if (--depth == 0)
+        return 0;
+    } else if (a == open_list && b == open_list)
+      ++depth;
+    else {
+      // Integer vs. list; the integer side doesn't move but gets
+      // wrapped
+      ++depth;
+      if (a >= 0) {
+        ++lc.wrapped;
+        rc.advance();
+      } else {
+        ++rc.wrapped;
+        lc.advance();
+      }
+      continue;
+    }
+    lc.advance();
+    rc.advance();
+  }
+}
+
+// All of stdin, mapped if it's a file and read otherwise.  Packets
+// are well-formed, so comparisons never look past the end of one.
+struct input {
+  char const *data{nullptr};
+  size_t len{0};
+  vector<char> copy;
+
+  input();
+
+  // Starts of the packets, i.e., of the nonempty lines
+  vector<char const *> packets() const;
+};
+
+input::input() {
+  struct stat st;
+  if (fstat(0, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    len = st.st_size;
+    void *p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, 0, 0);
+    if (p != MAP_FAILED) {
+      data = (char const *)p;
+      return;
+    }
+  }
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0)
+    copy.insert(copy.end(), buf, buf + n);
+  len = copy.size();
+  data = copy.data();
+}
+
+vector<char const *> input::packets() const {
+  vector<char const *> starts;
+  char const *end = data + len;
+  for (char const *s = data; s < end; ) {
+    char const *nl = (char const *)memchr(s, '\n', end - s);
+    if (!nl)
+      nl = end;
+    if (nl > s) {
+      assert(*s == '[');
+      starts.push_back(s);
+    }
+    s = nl + 1;
+  }
+  return starts;
+}
+
+void part1() {
+  input in;
+  auto pkts = in.packets();
+  assert(pkts.size() % 2 == 0);
+  int ans = 0;
+  for (size_t i = 0; i < pkts.size(); i += 2)
+    if (compare(pkts[i], pkts[i + 1]) < 0)
+      ans += i / 2 + 1;
+  cout << ans << '\n';
+}
+
+void part2() {
+  input in;
+  auto pkts = in.packets();
+  char const *div2 = "[[2]]";
+  char const *div6 = "[[6]]";
+  pkts.push_back(div2);
+  pkts.push_back(div6);
+  auto less = [](char const *p1, char const *p2) {
+                return compare(p1, p2) < 0;
+              };
+  sort(pkts.begin(), pkts.end(), less);
+  auto index_of = [&](char const *div) {
+                    auto p = find_if(pkts.begin(), pkts.end(),
+                                     [&](char const *p) {
+                                       return compare(p, div) == 0;
+                                     });
+                    return p - pkts.begin() + 1;
+                  };
+  cout << index_of(div2) * index_of(div6) << '\n';
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " partnum < input\n";
+    exit(1);
+  }
+  if (*argv[1] == '1')
+    part1();
+  else
+    part2();
+  return 0;
+}
@@ -6,9 +6,11 @@
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <map>
+#include <vector>
 #include <optional>
 #include <utility>
+#include <algorithm>
+#include <cstring>
 #include <cassert>
 
 using namespace std;
@@ -16,10 +18,15 @@ using namespace std;
 using coord = pair<int, int>;
 
 struct cave {
-  // Tiles that contain something, either rock or earlier sand
-  map<coord, char> tiles;
+  // Rock paths as read, kept until the grid size is known
+  vector<vector<coord>> paths;
   // Any sand reaching this level falls into the abyss
   int abyss{0};
+  // Row-major tiles, ' ' for nothing, 'X' for rock, 'o' for sand.
+  // Columns are x - x0, rows are y from 0 through the floor.
+  vector<char> tiles;
+  int x0{0};
+  int w{0};
 
   // Construct from stdin
   cave();
@@ -27,13 +34,15 @@ struct cave {
   // Add stuff
   void path(string const &s);
   void segment(coord c1, coord const &c2);
-  void rock(coord const &c) { tiles[c] = 'X'; abyss = max(abyss, c.second); }
   void floor();
 
+  char &tile(coord const &c) {
+    return tiles[size_t(c.second) * w + (c.first - x0)];
+  }
+
   // What's at a coordinate, ' ' for nothing
   char at(coord const &c) const {
-    auto p = tiles.find(c);
-    return p == tiles.end() ? ' ' : p->second;
+    return tiles[size_t(c.second) * w + (c.first - x0)];
   }
 
   // Add some sand, return 'A' for reaching the abyss, 'o' if blocked
@@ -44,38 +53,62 @@ cave::cave() {
   string line;
   while (getline(cin, line))
     path(line);
+  // Sand can't get further to the side than it falls, and it falls at
+  // most to the floor, so the grid is just big enough for that and for
+  // all the rock
+  int min_x = 500;
+  int max_x = 500;
+  for (auto const &p : paths)
+    for (auto const &c : p) {
+      assert(c.second >= 0);
+      min_x = min(min_x, c.first);
+      max_x = max(max_x, c.first);
+      abyss = max(abyss, c.second);
+    }
+  int floor = abyss + 2;
+  x0 = min(min_x, 500 - floor - 1);
+  w = max(max_x, 500 + floor + 1) - x0 + 1;
+  tiles.assign(size_t(floor + 1) * w, ' ');
+  for (auto const &p : paths) {
+    segment(p[0], p[0]);
+    for (size_t i = 1; i < p.size(); ++i)
+      segment(p[i - 1], p[i]);
+  }
+  paths.clear();
   assert(at({ 500, 0 }) == ' ');
 }
 
 void cave::path(string const &s) {
   stringstream ss(s);
-  coord c1, c2;
+  coord c;
   char comma;
   string to;
-  ss >> c1.first >> comma >> c1.second;
-  while (ss >> to >> c2.first >> comma >> c2.second) {
-    segment(c1, c2);
-    c1 = c2;
-  }
+  ss >> c.first >> comma >> c.second;
+  paths.emplace_back(1, c);
+  while (ss >> to >> c.first >> comma >> c.second)
+    paths.back().push_back(c);
 }
 
 void cave::segment(coord c1, coord const &c2) {
-  auto step = [](int d1, int d2) { return d1 == d2 ? 0 : (d1 < d2 ? +1 : -1); };
-  int dx = step(c1.first, c2.first);
-  int dy = step(c1.second, c2.second);
-  rock(c1);
-  while (c1 != c2) {
-    c1.first += dx;
-    c1.second += dy;
-    rock(c1);
+  if (c1.second == c2.second) {
+    // Horizontal, all in one row
+    int x1 = min(c1.first, c2.first);
+    int x2 = max(c1.first, c2.first);
+    memset(&tile({ x1, c1.second }), 'X', x2 - x1 + 1);
+    return;
   }
+  assert(c1.first == c2.first);
+  int y1 = min(c1.second, c2.second);
+  int y2 = max(c1.second, c2.second);
+  for (int y = y1; y <= y2; ++y)
+    tile({ c1.first, y }) = 'X';
 }
 
 void cave::floor() {
-  // abyss has the maximum y seen so far
+  // The grid was made with room for the floor as its last row
   int floor = abyss + 2;
-  // Sand going diagonally can get floor units to the side
-  segment({ 500 - floor - 1, floor }, { 500 + floor + 1, floor });
+  memset(&tile({ x0, floor }), 'X', w);
+  abyss = floor;
 }
 
 char cave::reaches() {
@@ -88,7 +121,7 @@ char cave::reaches() {
       if (!next && at({ c.first + dx, c.second + 1 }) == ' ')
         next = { c.first + dx, c.second + 1 };
     if (!next) {
-      tiles[c] = 'o';
+      tile(c) = 'o';
       return ' ';
     }
     c = *next;